@@ -4,18 +4,33 @@
 #include <iostream>
 #include <vector>
 #include <limits>
+#include <cstdint>
 
 #include "../Graph/Graph.hpp"
 #include "TopologicalSort.hpp"
+#include "../ThreadPool.hpp"
 
 using namespace std;
 
+// below this many vertices a level-synchronous pass costs more than it saves
+const int PARALLEL_LONGEST_PATH_THRESHOLD = 4096;
+// vertices of a level relaxed per task
+const int PARALLEL_LONGEST_PATH_CHUNK = 256;
+
 // Define a class for longest path
 template <class VertexData, class EdgeData>
 class LongestPath
 {
 private:
 public:
+    // levels of a graph kept across evaluations, rebuilt once its edges change
+    struct LevelCache
+    {
+        bool valid = false;
+        uint64_t structure = 0;
+        vector<vector<int>> levels;
+    };
+
     // Method to perform longest path
     static vector<float> find(Graph<VertexData, EdgeData> &graph)
     {
@@ -90,6 +105,132 @@ public:
 
         return make_pair(distances, reversedPath);
     }
+
+    /*
+     * Longest path that gives up once exceeds(distance) holds for a distance met,
+     * for a caller that only needs the length while it stays below a bound. Every
+     * distance is a lower bound of the length. Returns false when it gave up, the
+     * distances left partial.
+     */
+    template <class Exceeds>
+    static bool findBounded(Graph<VertexData, EdgeData> &graph, vector<float> &distances, const Exceeds &exceeds)
+    {
+        vector<int> topologicalOrder = Topological<VertexData, EdgeData>::sort(graph);
+        distances.assign(graph.size(), -numeric_limits<float>::infinity());
+        distances[topologicalOrder[0]] = 0;
+        float longest = 0;
+
+        for (size_t i = 0; i < topologicalOrder.size(); ++i)
+        {
+            int node = topologicalOrder[i];
+            for (const auto &edge : graph.getInEdgeMap(node))
+            {
+                distances[node] = max(distances[node], distances[edge.first] + edge.second);
+            }
+            if (distances[node] > longest)
+            {
+                longest = distances[node];
+                if (exceeds(longest))
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    /*
+     * Forward pass for the longest distance from the source, backward pass for the
+     * longest distance to the sink. The slack of a vertex is how much it can be
+     * pushed without lengthening the critical path; critical vertices have zero slack.
+     */
+    static pair<vector<float>, vector<float>> findSlack(Graph<VertexData, EdgeData> &graph)
+    {
+        vector<int> topologicalOrder = Topological<VertexData, EdgeData>::sort(graph);
+        vector<float> distances = find(graph, topologicalOrder);
+        vector<float> tails(graph.size(), -numeric_limits<float>::infinity());
+        tails[topologicalOrder.back()] = 0;
+
+        for (int i = static_cast<int>(topologicalOrder.size()) - 1; i >= 0; --i)
+        {
+            int node = topologicalOrder[i];
+            vector<pair<int, float>> outEdges = graph.getOutEdges(node);
+            for (const auto &edge : outEdges)
+            {
+                tails[node] = max(tails[node], edge.second + tails[edge.first]);
+            }
+        }
+
+        float length = distances[topologicalOrder.back()];
+        vector<float> slacks(graph.size());
+        for (int i = 0; i < graph.size(); ++i)
+        {
+            slacks[i] = length - distances[i] - tails[i];
+        }
+
+        return make_pair(distances, slacks);
+    }
+
+    /*
+     * Level-synchronous longest path: the vertices of a level only depend on earlier
+     * levels, so each level is relaxed concurrently, every vertex pulling from its
+     * in-edges. Small graphs fall back to the serial pass.
+     */
+    static vector<float> findParallel(Graph<VertexData, EdgeData> &graph, ThreadPool &pool, int threshold = PARALLEL_LONGEST_PATH_THRESHOLD)
+    {
+        if (graph.size() < threshold || pool.size() == 1)
+        {
+            return find(graph);
+        }
+        vector<vector<int>> levels = Topological<VertexData, EdgeData>::levels(graph);
+        return findParallel(graph, levels, pool);
+    }
+
+    // the levels of the previous call reused while the edges are the same
+    static vector<float> findParallel(Graph<VertexData, EdgeData> &graph, ThreadPool &pool, LevelCache &cache, int threshold = PARALLEL_LONGEST_PATH_THRESHOLD)
+    {
+        if (graph.size() < threshold || pool.size() == 1)
+        {
+            return find(graph);
+        }
+        if (!cache.valid || cache.structure != graph.getStructureHash())
+        {
+            cache.levels = Topological<VertexData, EdgeData>::levels(graph);
+            cache.structure = graph.getStructureHash();
+            cache.valid = true;
+        }
+        return findParallel(graph, cache.levels, pool);
+    }
+
+    // given the levels, find the longest path
+    static vector<float> findParallel(Graph<VertexData, EdgeData> &graph, const vector<vector<int>> &levels, ThreadPool &pool)
+    {
+        vector<float> distances(graph.size(), -numeric_limits<float>::infinity());
+        for (int node : levels[0])
+        {
+            distances[node] = 0;
+        }
+
+        for (size_t l = 1; l < levels.size(); ++l)
+        {
+            const vector<int> &level = levels[l];
+            pool.parallelFor(static_cast<int>(level.size()), PARALLEL_LONGEST_PATH_CHUNK, [&](int begin, int end)
+                             {
+                for (int i = begin; i < end; ++i)
+                {
+                    int node = level[i];
+                    float distance = -numeric_limits<float>::infinity();
+                    for (const auto &edge : graph.getInEdgeMap(node))
+                    {
+                        distance = max(distance, distances[edge.first] + edge.second);
+                    }
+                    distances[node] = distance;
+                } });
+        }
+
+        return distances;
+    }
 };
 
 #endif // LONGESTPATH_HPP
\ No newline at end of file
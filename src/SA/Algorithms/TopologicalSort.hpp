@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <vector>
+#include <algorithm>
 
 #include "../Graph/Graph.hpp"
 
@@ -49,6 +50,40 @@ public:
 
         return topologicalOrder;
     }
+
+    // Kahn wavefronts: every vertex of a level only has in-edges from earlier levels
+    static vector<vector<int>> levels(Graph<VertexData, EdgeData> &graph)
+    {
+        vector<vector<int>> levels(1);
+        vector<int> inDegrees(graph.size());
+        for (int i = 0; i < graph.size(); ++i)
+        {
+            inDegrees[i] = static_cast<int>(graph.getInEdgeMap(i).size());
+            if (inDegrees[i] == 0)
+            {
+                levels[0].push_back(i);
+            }
+        }
+
+        while (!levels.back().empty())
+        {
+            vector<int> level;
+            for (int node : levels.back())
+            {
+                for (const auto &edge : graph.getOutEdgeMap(node))
+                {
+                    if (--inDegrees[edge.first] == 0)
+                    {
+                        level.push_back(edge.first);
+                    }
+                }
+            }
+            levels.push_back(level);
+        }
+        levels.pop_back();
+
+        return levels;
+    }
 };
 
 #endif // TOPOLOGICALSORT_HPP
\ No newline at end of file
@@ -0,0 +1,243 @@
+#ifndef BSTARTREE_HPP
+#define BSTARTREE_HPP
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+/*
+ * Horizontal contour of the blocks placed so far, kept as a doubly-linked list
+ * of segments ordered by x. Every segment is the top of one block; segments are
+ * only ever cut from the left, so a segment ends where its block ends.
+ */
+class Contour
+{
+private:
+    int head;
+    vector<int> next, prev, start, top;
+
+public:
+    Contour(int numNodes = 0) : head(numNodes), next(numNodes + 1), prev(numNodes + 1), start(numNodes + 1), top(numNodes + 1) {}
+
+    inline void clear()
+    {
+        next[head] = -1;
+    }
+
+    inline int getHead() const
+    {
+        return head;
+    }
+
+    inline int getPrev(int segment) const
+    {
+        return prev[segment];
+    }
+
+    /*
+     * Place block b spanning [x, x + width) right after segment after, on top of
+     * every segment it covers. Covered segments drop out of the list, so each
+     * segment is walked over once per packing. Returns the y of the block.
+     */
+    inline int place(int b, int after, int x, int width, int height, const vector<int> &xs, const vector<int> &widths)
+    {
+        int x2 = x + width;
+        int y = 0;
+        int current = next[after];
+        while (current != -1 && xs[current] + widths[current] <= x2)
+        {
+            y = max(y, top[current]);
+            current = next[current];
+        }
+        if (current != -1 && start[current] < x2)
+        {
+            y = max(y, top[current]);
+            start[current] = x2;
+        }
+
+        next[after] = b;
+        prev[b] = after;
+        next[b] = current;
+        if (current != -1)
+        {
+            prev[current] = b;
+        }
+        start[b] = x;
+        top[b] = y + height;
+
+        return y;
+    }
+};
+
+/*
+ * B*-tree over the blocks. The left child of a node is placed right next to it,
+ * the right child on top of it at the same x. Tree nodes are slots holding a
+ * block, so swapping two blocks only exchanges their labels.
+ */
+class BStarTree
+{
+private:
+    int numNodes;
+    int root;
+    vector<int> parent, left, right;
+    vector<int> blocks;
+
+    // stack of the preorder traversal used by pack
+    vector<int> stack;
+
+    // replace the child link of p pointing to oldChild
+    inline void relink(int p, int oldChild, int newChild)
+    {
+        if (p == -1)
+        {
+            root = newChild;
+        }
+        else if (left[p] == oldChild)
+        {
+            left[p] = newChild;
+        }
+        else
+        {
+            right[p] = newChild;
+        }
+        if (newChild != -1)
+        {
+            parent[newChild] = p;
+        }
+    }
+
+public:
+    BStarTree(int numNodes = 0) : numNodes(numNodes), root(numNodes > 0 ? 0 : -1), parent(numNodes, -1), left(numNodes, -1), right(numNodes, -1), blocks(numNodes)
+    {
+        // start from a complete binary tree
+        for (int i = 0; i < numNodes; i++)
+        {
+            blocks[i] = i;
+            if (2 * i + 1 < numNodes)
+            {
+                left[i] = 2 * i + 1;
+                parent[2 * i + 1] = i;
+            }
+            if (2 * i + 2 < numNodes)
+            {
+                right[i] = 2 * i + 2;
+                parent[2 * i + 2] = i;
+            }
+        }
+        stack.reserve(numNodes);
+    }
+
+    inline int size() const
+    {
+        return numNodes;
+    }
+
+    inline int getBlock(int node) const
+    {
+        return blocks[node];
+    }
+
+    inline void swapBlocks(int node1, int node2)
+    {
+        swap(blocks[node1], blocks[node2]);
+    }
+
+    /*
+     * Delete the block at node and insert it as the left or right child of target.
+     * The block first sinks to a leaf by trading places with a child, which is how
+     * a node with children is deleted; the freed leaf then takes over the child
+     * slot of target, adopting the previous child on the same side.
+     */
+    void move(int node, int target, bool asLeft)
+    {
+        while (left[node] != -1 || right[node] != -1)
+        {
+            int child = left[node] != -1 ? left[node] : right[node];
+            swap(blocks[node], blocks[child]);
+            if (target == child)
+            {
+                target = node;
+            }
+            node = child;
+        }
+        if (node == target)
+        {
+            return;
+        }
+        relink(parent[node], node, -1);
+
+        int child = asLeft ? left[target] : right[target];
+        if (asLeft)
+        {
+            left[target] = node;
+            left[node] = child;
+        }
+        else
+        {
+            right[target] = node;
+            right[node] = child;
+        }
+        parent[node] = target;
+        if (child != -1)
+        {
+            parent[child] = node;
+        }
+    }
+
+    /*
+     * Pack the blocks in preorder on top of the contour. Fills the lower-left
+     * corner of every block and returns the width and height of the packing.
+     */
+    pair<int, int> pack(const vector<int> &widths, const vector<int> &heights, Contour &contour, vector<int> &xs, vector<int> &ys)
+    {
+        contour.clear();
+        int width = 0, height = 0;
+
+        stack.clear();
+        stack.push_back(root);
+        while (!stack.empty())
+        {
+            int node = stack.back();
+            stack.pop_back();
+            int b = blocks[node];
+
+            int after;
+            if (parent[node] == -1)
+            {
+                xs[b] = 0;
+                after = contour.getHead();
+            }
+            else if (left[parent[node]] == node)
+            {
+                int p = blocks[parent[node]];
+                xs[b] = xs[p] + widths[p];
+                after = p;
+            }
+            else
+            {
+                int p = blocks[parent[node]];
+                xs[b] = xs[p];
+                after = contour.getPrev(p);
+            }
+            ys[b] = contour.place(b, after, xs[b], widths[b], heights[b], xs, widths);
+
+            width = max(width, xs[b] + widths[b]);
+            height = max(height, ys[b] + heights[b]);
+
+            if (right[node] != -1)
+            {
+                stack.push_back(right[node]);
+            }
+            if (left[node] != -1)
+            {
+                stack.push_back(left[node]);
+            }
+        }
+
+        return make_pair(width, height);
+    }
+};
+
+#endif // BSTARTREE_HPP
@@ -0,0 +1,148 @@
+#ifndef BSTARTREESCHEDULER_HPP
+#define BSTARTREESCHEDULER_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include "Macro.hpp"
+#include "SchedulerBase.hpp"
+#include "BStarTree.hpp"
+
+using namespace std;
+
+enum BStarTreeMoves
+{
+    ROTATE,
+    SWAP,
+    MOVE
+};
+
+// Define a scheduler packing the blocks with a B*-tree instead of constraint graphs
+class BStarTreeScheduler : public SchedulerBase
+{
+private:
+    BStarTree tree, previousTree;
+    Contour contour;
+    vector<int> widths, heights, xs, ys;
+
+    BStarTreeMoves previousMove;
+    pair<int, int> previousIndices;
+
+    // rotate: change dimensions
+    inline void rotate(int v, int aspectIndex = -1)
+    {
+        int originalIndex = macroDimensionsIndex[v];
+        if (aspectIndex == -1)
+        {
+            aspectIndex = (originalIndex + 1) % macroDimensions[v].size();
+        }
+        macroDimensionsIndex[v] = aspectIndex;
+        widths[v] = getWidth(v);
+        heights[v] = getHeight(v);
+        previousMove = ROTATE;
+        previousIndices = {v, originalIndex};
+    }
+
+    // swap: exchange the blocks of two nodes
+    inline void swapNodes(int n1, int n2)
+    {
+        tree.swapBlocks(n1, n2);
+        previousMove = SWAP;
+        previousIndices = {n1, n2};
+    }
+
+    // move: delete a node and insert it next to another one
+    inline void moveNode(int node, int target, bool asLeft)
+    {
+        previousTree = tree;
+        tree.move(node, target, asLeft);
+        previousMove = MOVE;
+    }
+
+public:
+    BStarTreeScheduler(vector<Macro> &macros, float minAspectRatio, float maxAspectRatio, int k = 7, int timeLimit = 10)
+        : SchedulerBase(macros, minAspectRatio, maxAspectRatio, k, timeLimit),
+          tree(numNodes), previousTree(numNodes), contour(numNodes),
+          widths(numNodes), heights(numNodes), xs(numNodes), ys(numNodes)
+    {
+        for (int i = 0; i < numNodes; i++)
+        {
+            widths[i] = getWidth(i);
+            heights[i] = getHeight(i);
+        }
+    }
+
+    // event handlers
+    inline void makeRandomModification()
+    {
+        countMove();
+        int n1 = getRandomNumber(0, numNodes - 1);
+        int n2 = getRandomNumber(0, numNodes - 1);
+        if (n1 == n2)
+        {
+            n2 = (n1 + 1) % numNodes;
+        }
+        // make a random modification to the current tree (state)
+        int move = getRandomNumber(ROTATE, MOVE);
+        if (move == ROTATE && macroDimensions[tree.getBlock(n1)].size() == 1)
+        {
+            move = getRandomNumber(SWAP, MOVE);
+        }
+        if (numNodes == 1)
+        {
+            move = ROTATE;
+        }
+        switch (move)
+        {
+        case ROTATE:
+            rotate(tree.getBlock(n1));
+            break;
+        case SWAP:
+            swapNodes(n1, n2);
+            break;
+        case MOVE:
+            moveNode(n1, n2, getRandomNumber(0, 1) == 0);
+            break;
+
+        default:
+            cerr << "Invalid move" << endl;
+            break;
+        }
+    }
+
+    inline double evaluateState()
+    {
+        pair<int, int> size = tree.pack(widths, heights, contour, xs, ys);
+        return max(size.first, size.second);
+    }
+
+    inline void reject()
+    {
+        rejectCount++;
+
+        switch (previousMove)
+        {
+        case ROTATE:
+            rotate(previousIndices.first, previousIndices.second);
+            break;
+        case SWAP:
+            swapNodes(previousIndices.first, previousIndices.second);
+            break;
+        case MOVE:
+            swap(tree, previousTree);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    void saveFloorplan(string filename)
+    {
+        pair<int, int> size = tree.pack(widths, heights, contour, xs, ys);
+        writeFloorplan(filename, xs, ys, size.first, size.second);
+    }
+};
+
+#endif // BSTARTREESCHEDULER_HPP
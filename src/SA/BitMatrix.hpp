@@ -0,0 +1,124 @@
+#ifndef BITMATRIX_HPP
+#define BITMATRIX_HPP
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+using namespace std;
+
+// Define a square matrix of bits stored row by row in 64-bit words
+class BitMatrix
+{
+private:
+    int numNodes;
+    int wordsPerRow;
+    vector<uint64_t> words;
+
+public:
+    BitMatrix(int numNodes = 0) : numNodes(numNodes), wordsPerRow((numNodes + 63) / 64), words(static_cast<size_t>(numNodes) * wordsPerRow, 0) {}
+
+    inline int size() const
+    {
+        return numNodes;
+    }
+
+    inline int getWordsPerRow() const
+    {
+        return wordsPerRow;
+    }
+
+    inline bool get(int row, int column) const
+    {
+        return (words[static_cast<size_t>(row) * wordsPerRow + (column >> 6)] >> (column & 63)) & 1;
+    }
+
+    inline void set(int row, int column)
+    {
+        words[static_cast<size_t>(row) * wordsPerRow + (column >> 6)] |= uint64_t(1) << (column & 63);
+    }
+
+    inline void reset(int row, int column)
+    {
+        words[static_cast<size_t>(row) * wordsPerRow + (column >> 6)] &= ~(uint64_t(1) << (column & 63));
+    }
+
+    inline uint64_t *row(int row)
+    {
+        return &words[static_cast<size_t>(row) * wordsPerRow];
+    }
+
+    inline const uint64_t *row(int row) const
+    {
+        return &words[static_cast<size_t>(row) * wordsPerRow];
+    }
+
+    // row |= mask
+    inline void orRow(int row, const vector<uint64_t> &mask)
+    {
+        uint64_t *r = this->row(row);
+        for (int w = 0; w < wordsPerRow; w++)
+        {
+            r[w] |= mask[w];
+        }
+    }
+
+    // row &= ~mask
+    inline void clearRow(int row, const vector<uint64_t> &mask)
+    {
+        uint64_t *r = this->row(row);
+        for (int w = 0; w < wordsPerRow; w++)
+        {
+            r[w] &= ~mask[w];
+        }
+    }
+
+    // bits of a column gathered into a row-shaped mask
+    vector<uint64_t> getColumn(int column) const
+    {
+        vector<uint64_t> mask(wordsPerRow, 0);
+        for (int i = 0; i < numNodes; i++)
+        {
+            if (get(i, column))
+            {
+                mask[i >> 6] |= uint64_t(1) << (i & 63);
+            }
+        }
+        return mask;
+    }
+
+    vector<uint64_t> getRow(int row) const
+    {
+        const uint64_t *r = this->row(row);
+        return vector<uint64_t>(r, r + wordsPerRow);
+    }
+
+    // exchange the rows and the columns of two nodes
+    void swapNodes(int a, int b)
+    {
+        uint64_t *ra = row(a), *rb = row(b);
+        for (int w = 0; w < wordsPerRow; w++)
+        {
+            swap(ra[w], rb[w]);
+        }
+        for (int i = 0; i < numNodes; i++)
+        {
+            bool bitA = get(i, a), bitB = get(i, b);
+            if (bitA != bitB)
+            {
+                if (bitA)
+                {
+                    reset(i, a);
+                    set(i, b);
+                }
+                else
+                {
+                    reset(i, b);
+                    set(i, a);
+                }
+            }
+        }
+    }
+};
+
+#endif // BITMATRIX_HPP
@@ -0,0 +1,180 @@
+#ifndef COMPACTSEQUENCEPAIR_HPP
+#define COMPACTSEQUENCEPAIR_HPP
+
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+/*
+ * Sequence pair as two permutations and the block sizes, cheap to copy and
+ * evaluated in O(n log n): walking one sequence, a block starts at the largest end
+ * among the visited blocks on the right side of it in the other sequence, a prefix
+ * maximum kept in a Fenwick tree.
+ */
+class CompactSequencePair
+{
+private:
+    int numNodes;
+    mutable vector<int> tree;
+
+    inline void clearTree() const
+    {
+        fill(tree.begin(), tree.end(), 0);
+    }
+
+    // maximum over the positions [0, p)
+    inline int query(int p) const
+    {
+        int result = 0;
+        for (; p > 0; p -= p & -p)
+        {
+            result = max(result, tree[p]);
+        }
+        return result;
+    }
+
+    inline void update(int p, int value) const
+    {
+        for (p++; p <= numNodes; p += p & -p)
+        {
+            tree[p] = max(tree[p], value);
+        }
+    }
+
+    inline void swapPositions(vector<int> &seq, vector<int> &pos, int v1, int v2)
+    {
+        swap(seq[pos[v1]], seq[pos[v2]]);
+        swap(pos[v1], pos[v2]);
+    }
+
+public:
+    // block at each position of the two sequences, and the inverse positions
+    vector<int> seqX, seqY, posX, posY;
+    vector<int> widths, heights;
+
+    CompactSequencePair(int numNodes = 0)
+        : numNodes(numNodes), tree(numNodes + 1), seqX(numNodes), seqY(numNodes), posX(numNodes), posY(numNodes), widths(numNodes), heights(numNodes)
+    {
+        for (int i = 0; i < numNodes; i++)
+        {
+            seqX[i] = seqY[i] = posX[i] = posY[i] = i;
+        }
+    }
+
+    inline int size() const
+    {
+        return numNodes;
+    }
+
+    // rebuild the sequences after the positions were written
+    void updateSequences()
+    {
+        for (int i = 0; i < numNodes; i++)
+        {
+            seqX[posX[i]] = i;
+            seqY[posY[i]] = i;
+        }
+    }
+
+    inline void swapX(int v1, int v2)
+    {
+        swapPositions(seqX, posX, v1, v2);
+    }
+
+    inline void swapY(int v1, int v2)
+    {
+        swapPositions(seqY, posY, v1, v2);
+    }
+
+    inline void swapBoth(int v1, int v2)
+    {
+        swapX(v1, v2);
+        swapY(v1, v2);
+    }
+
+    inline void setShape(int v, int width, int height)
+    {
+        widths[v] = width;
+        heights[v] = height;
+    }
+
+    // blocks left of b come before it in both sequences
+    int findWidth(vector<int> *xs = nullptr) const
+    {
+        clearTree();
+        int width = 0;
+        for (int i = 0; i < numNodes; i++)
+        {
+            int b = seqX[i];
+            int x = query(posY[b]);
+            if (xs)
+            {
+                (*xs)[b] = x;
+            }
+            update(posY[b], x + widths[b]);
+            width = max(width, x + widths[b]);
+        }
+        return width;
+    }
+
+    // blocks below b come after it in seqX and before it in seqY
+    int findHeight(vector<int> *ys = nullptr) const
+    {
+        clearTree();
+        int height = 0;
+        for (int i = 0; i < numNodes; i++)
+        {
+            int b = seqY[i];
+            int p = numNodes - 1 - posX[b];
+            int y = query(p);
+            if (ys)
+            {
+                (*ys)[b] = y;
+            }
+            update(p, y + heights[b]);
+            height = max(height, y + heights[b]);
+        }
+        return height;
+    }
+
+    /*
+     * Longest path through a sub-sequence pair cut out of a larger one: every block
+     * starts no earlier than its arrival and is followed by a fixed departure length.
+     */
+    int findWidth(const vector<int> &arrivals, const vector<int> &departures) const
+    {
+        clearTree();
+        int width = 0;
+        for (int i = 0; i < numNodes; i++)
+        {
+            int b = seqX[i];
+            int x = max(query(posY[b]), arrivals[b]);
+            update(posY[b], x + widths[b]);
+            width = max(width, x + widths[b] + departures[b]);
+        }
+        return width;
+    }
+
+    int findHeight(const vector<int> &arrivals, const vector<int> &departures) const
+    {
+        clearTree();
+        int height = 0;
+        for (int i = 0; i < numNodes; i++)
+        {
+            int b = seqY[i];
+            int p = numNodes - 1 - posX[b];
+            int y = max(query(p), arrivals[b]);
+            update(p, y + heights[b]);
+            height = max(height, y + heights[b] + departures[b]);
+        }
+        return height;
+    }
+
+    inline double evaluate() const
+    {
+        return max(findWidth(), findHeight());
+    }
+};
+
+#endif // COMPACTSEQUENCEPAIR_HPP
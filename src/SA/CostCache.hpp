@@ -0,0 +1,144 @@
+#ifndef COSTCACHE_HPP
+#define COSTCACHE_HPP
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+
+using namespace std;
+
+// Zobrist keys, derived on the fly so no table of size O(n^2) is needed
+class Zobrist
+{
+private:
+    static inline uint64_t splitmix64(uint64_t x)
+    {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+public:
+    // a block is identified by its current shape, so layouts that only differ by
+    // exchanging blocks of identical shape hash the same
+    static inline uint64_t shape(int width, int height)
+    {
+        return (static_cast<uint64_t>(width) << 32) | static_cast<uint32_t>(height);
+    }
+
+    // a block told apart from the other blocks of its shape, once its pins matter
+    static inline uint64_t block(int id)
+    {
+        return splitmix64(~static_cast<uint64_t>(id));
+    }
+
+    // key of a block of the given shape at its positions in sequence X and sequence Y
+    static inline uint64_t key(uint64_t shape, int positionX, int positionY)
+    {
+        return splitmix64(splitmix64(shape) ^ (static_cast<uint64_t>(positionX) << 32) ^ static_cast<uint32_t>(positionY));
+    }
+};
+
+/*
+ * Bounded, direct-mapped cache from state hash to cost. Each slot stores the
+ * cost bits and the key xored with them, so a torn read from a concurrent
+ * writer simply fails the check instead of returning a wrong cost. A flag kept
+ * with the cost is folded into the key as a salt.
+ */
+class CostCache
+{
+private:
+    size_t mask;
+    unique_ptr<atomic<uint64_t>[]> keys, values;
+
+    static const uint64_t FLAG_SALT = 0xD6E8FEB86659FD93ULL;
+
+    atomic<uint64_t> hits, lookups;
+
+    static inline uint64_t toBits(double cost)
+    {
+        uint64_t bits;
+        memcpy(&bits, &cost, sizeof(bits));
+        return bits;
+    }
+
+    static inline double fromBits(uint64_t bits)
+    {
+        double cost;
+        memcpy(&cost, &bits, sizeof(cost));
+        return cost;
+    }
+
+public:
+    // capacity is rounded up to a power of two
+    CostCache(size_t capacity) : hits(0), lookups(0)
+    {
+        size_t size = 1;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        mask = size - 1;
+        keys.reset(new atomic<uint64_t>[size]());
+        values.reset(new atomic<uint64_t>[size]());
+    }
+
+    inline bool find(uint64_t hash, double &cost, bool &flag)
+    {
+        lookups.fetch_add(1, memory_order_relaxed);
+        size_t index = hash & mask;
+        uint64_t value = values[index].load(memory_order_relaxed);
+        uint64_t key = keys[index].load(memory_order_relaxed) ^ value;
+        if (key != hash && key != (hash ^ FLAG_SALT))
+        {
+            return false;
+        }
+        hits.fetch_add(1, memory_order_relaxed);
+        cost = fromBits(value);
+        flag = key != hash;
+        return true;
+    }
+
+    inline void insert(uint64_t hash, double cost, bool flag = false)
+    {
+        size_t index = hash & mask;
+        uint64_t value = toBits(cost);
+        values[index].store(value, memory_order_relaxed);
+        keys[index].store(hash ^ value ^ (flag ? FLAG_SALT : 0), memory_order_relaxed);
+    }
+
+    // forget every cost, once the cost function changes
+    void clear()
+    {
+        for (size_t i = 0; i <= mask; i++)
+        {
+            keys[i].store(0, memory_order_relaxed);
+            values[i].store(0, memory_order_relaxed);
+        }
+    }
+
+    inline size_t capacity() const
+    {
+        return mask + 1;
+    }
+
+    inline uint64_t getHits() const
+    {
+        return hits.load(memory_order_relaxed);
+    }
+
+    inline uint64_t getLookups() const
+    {
+        return lookups.load(memory_order_relaxed);
+    }
+
+    inline void resetCounters()
+    {
+        hits.store(0, memory_order_relaxed);
+        lookups.store(0, memory_order_relaxed);
+    }
+};
+
+#endif // COSTCACHE_HPP
@@ -0,0 +1,255 @@
+#ifndef CPUTOPOLOGY_HPP
+#define CPUTOPOLOGY_HPP
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <thread>
+#include <algorithm>
+#include <cctype>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <dirent.h>
+#endif
+
+using namespace std;
+
+/*
+ * Hardware threads of this machine as listed under /sys/devices/system/cpu, with
+ * their package, core and NUMA node. The placement order spreads threads over the
+ * packages and gives every core one thread before any core gets a second, so
+ * annealing threads first land on separate cores and separate memory controllers.
+ * Without sysfs every hardware thread counts as its own core on one package.
+ */
+class CpuTopology
+{
+public:
+    struct Cpu
+    {
+        int id;
+        int package = 0;
+        int core = 0;
+        int node = 0;
+    };
+
+private:
+    vector<Cpu> cpus;
+    vector<int> placement;
+
+    static bool readInt(const string &path, int &value)
+    {
+        ifstream file(path);
+        return static_cast<bool>(file >> value);
+    }
+
+    // "0-3,8,10-11" to its cpus
+    static vector<int> parseList(const string &list)
+    {
+        vector<int> ids;
+        stringstream ss(list);
+        string range;
+        while (getline(ss, range, ','))
+        {
+            size_t dash = range.find('-');
+            int first = stoi(range.substr(0, dash));
+            int last = dash == string::npos ? first : stoi(range.substr(dash + 1));
+            for (int id = first; id <= last; id++)
+            {
+                ids.push_back(id);
+            }
+        }
+        return ids;
+    }
+
+    void read()
+    {
+#ifdef __linux__
+        string root = "/sys/devices/system/cpu/";
+        ifstream online(root + "online");
+        string list;
+        if (!getline(online, list) || list.empty())
+        {
+            return;
+        }
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        bool restricted = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+        for (int id : parseList(list))
+        {
+            if (restricted && !CPU_ISSET(id, &allowed))
+            {
+                continue;
+            }
+            Cpu cpu;
+            cpu.id = id;
+            string dir = root + "cpu" + to_string(id) + "/";
+            readInt(dir + "topology/physical_package_id", cpu.package);
+            readInt(dir + "topology/core_id", cpu.core);
+            // the node shows up as a nodeN link next to the topology
+            if (DIR *entries = opendir(dir.c_str()))
+            {
+                while (dirent *entry = readdir(entries))
+                {
+                    string name = entry->d_name;
+                    if (name.size() > 4 && name.compare(0, 4, "node") == 0 && isdigit(name[4]))
+                    {
+                        cpu.node = stoi(name.substr(4));
+                    }
+                }
+                closedir(entries);
+            }
+            cpus.push_back(cpu);
+        }
+#endif
+    }
+
+    void place()
+    {
+        // hardware threads of each core, cores of each package
+        map<int, map<int, vector<int>>> packages;
+        for (const Cpu &cpu : cpus)
+        {
+            packages[cpu.package][cpu.core].push_back(cpu.id);
+        }
+        vector<vector<vector<int>>> cores;
+        size_t maxCores = 0, maxThreads = 0;
+        for (auto &package : packages)
+        {
+            cores.emplace_back();
+            for (auto &core : package.second)
+            {
+                cores.back().push_back(core.second);
+                maxThreads = max(maxThreads, core.second.size());
+            }
+            maxCores = max(maxCores, cores.back().size());
+        }
+        for (size_t t = 0; t < maxThreads; t++)
+        {
+            for (size_t c = 0; c < maxCores; c++)
+            {
+                for (auto &package : cores)
+                {
+                    if (c < package.size() && t < package[c].size())
+                    {
+                        placement.push_back(package[c][t]);
+                    }
+                }
+            }
+        }
+    }
+
+public:
+    CpuTopology()
+    {
+        read();
+        if (cpus.empty())
+        {
+            int count = max(1u, thread::hardware_concurrency());
+            for (int id = 0; id < count; id++)
+            {
+                Cpu cpu;
+                cpu.id = id;
+                cpu.core = id;
+                cpus.push_back(cpu);
+            }
+        }
+        place();
+    }
+
+    inline const vector<Cpu> &getCpus() const
+    {
+        return cpus;
+    }
+
+    // the cpu of the i-th annealing thread, wrapping around when oversubscribed
+    inline int getPlacement(int i) const
+    {
+        return placement[i % placement.size()];
+    }
+
+    // the cpus of the first count annealing threads
+    vector<int> getPlacements(int count) const
+    {
+        vector<int> ids;
+        for (int i = 0; i < count; i++)
+        {
+            ids.push_back(getPlacement(i));
+        }
+        return ids;
+    }
+
+    void describe(ostream &logFile) const
+    {
+        set<int> packages, nodes;
+        set<pair<int, int>> cores;
+        for (const Cpu &cpu : cpus)
+        {
+            packages.insert(cpu.package);
+            nodes.insert(cpu.node);
+            cores.insert({cpu.package, cpu.core});
+        }
+        logFile << "CPU topology: " << packages.size() << " packages, " << nodes.size() << " NUMA nodes, "
+                << cores.size() << " cores, " << cpus.size() << " hardware threads" << endl;
+    }
+
+    // pin the calling thread, false where affinity is unsupported
+    static bool pin(int cpu)
+    {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)cpu;
+        return false;
+#endif
+    }
+
+    /*
+     * Pins the calling thread for the lifetime of the object and restores its
+     * previous affinity afterwards, for threads that outlive the run.
+     */
+    class ScopedPin
+    {
+    private:
+#ifdef __linux__
+        cpu_set_t previous;
+#endif
+        bool pinned = false;
+
+    public:
+        explicit ScopedPin(int cpu)
+        {
+#ifdef __linux__
+            if (pthread_getaffinity_np(pthread_self(), sizeof(previous), &previous) == 0)
+            {
+                pinned = pin(cpu);
+            }
+#else
+            (void)cpu;
+#endif
+        }
+
+        ~ScopedPin()
+        {
+#ifdef __linux__
+            if (pinned)
+            {
+                pthread_setaffinity_np(pthread_self(), sizeof(previous), &previous);
+            }
+#endif
+        }
+
+        ScopedPin(const ScopedPin &) = delete;
+        ScopedPin &operator=(const ScopedPin &) = delete;
+    };
+};
+
+#endif // CPUTOPOLOGY_HPP
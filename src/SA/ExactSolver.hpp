@@ -0,0 +1,457 @@
+#ifndef EXACTSOLVER_HPP
+#define EXACTSOLVER_HPP
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <functional>
+
+#include "CompactSequencePair.hpp"
+#include "ThreadPool.hpp"
+#include "../api.h"
+
+using namespace std;
+
+// blocks of the largest design the exact solver takes on
+const int EXACT_MAX_BLOCKS = 12;
+// blocks placed before the search splits into parallel subtrees
+const int EXACT_SPLIT_DEPTH = 3;
+
+/*
+ * Branch and bound over every sequence pair and shape choice of a small design,
+ * minimising max(width, height). Blocks are inserted one at a time, largest first,
+ * at every position of both partial sequences; a partial packing only grows as
+ * blocks are added, so its larger side bounds every completion, and every block
+ * still to come must fit into it alone below the incumbent. The search stops as
+ * soon as the incumbent meets the area and largest block bounds. Symmetries cut:
+ * transposing the floorplan reverses the X sequence and rotating it by 180 degrees
+ * reverses both, so the second block may go after the first in both sequences, and
+ * of two identical blocks the later one goes after the earlier one in X.
+ */
+class ExactSolver
+{
+private:
+    struct Partial
+    {
+        // positions of the placed blocks as indices into order, and their shapes
+        vector<int> localX, localY, shapes;
+    };
+
+    const vector<vector<pair<int, int>>> &dimensions;
+    int numNodes;
+    // blocks by descending area, and the earlier identical block of each, -1 if none
+    vector<int> order, identical;
+    int lowerBound;
+
+    atomic<int> bestCost;
+    mutex bestLock;
+    Partial best;
+    bool found = false;
+    atomic<long long> nodes;
+    atomic<bool> expired;
+    chrono::steady_clock::time_point deadline;
+
+    inline int getWidth(const Partial &partial, int i) const
+    {
+        return dimensions[order[i]][partial.shapes[i]].first;
+    }
+
+    inline int getHeight(const Partial &partial, int i) const
+    {
+        return dimensions[order[i]][partial.shapes[i]].second;
+    }
+
+    /*
+     * Longest paths through the constraint graphs of a partial. A block inserted at
+     * px in X and py in Y only lengthens the paths through itself, so the packing
+     * with it is max(width, arrival + w + departure) wide, where the arrival is the
+     * latest end of the blocks left of it and the departure the longest path from
+     * the blocks right of it, both 2D prefix maxima over the insertion positions.
+     */
+    struct Profile
+    {
+        int width, height;
+        int left[EXACT_MAX_BLOCKS + 1][EXACT_MAX_BLOCKS + 1], right[EXACT_MAX_BLOCKS + 1][EXACT_MAX_BLOCKS + 1];
+        int below[EXACT_MAX_BLOCKS + 1][EXACT_MAX_BLOCKS + 1], above[EXACT_MAX_BLOCKS + 1][EXACT_MAX_BLOCKS + 1];
+
+        // larger side of the packing with a w by h block inserted at px and py
+        inline int cost(int px, int py, int w, int h) const
+        {
+            return max(max(width, left[px][py] + w + right[px][py]), max(height, below[px][py] + h + above[px][py]));
+        }
+    };
+
+    void profile(const Partial &partial, int count, Profile &result) const
+    {
+        int posX[EXACT_MAX_BLOCKS], posY[EXACT_MAX_BLOCKS];
+        int xEnd[EXACT_MAX_BLOCKS], xTail[EXACT_MAX_BLOCKS], yEnd[EXACT_MAX_BLOCKS], yTail[EXACT_MAX_BLOCKS];
+        for (int p = 0; p < count; p++)
+        {
+            posX[partial.localX[p]] = p;
+            posY[partial.localY[p]] = p;
+        }
+        // a left of b: before b in both sequences, a below b: after b in X and before it in Y
+        result.width = result.height = 0;
+        for (int p = 0; p < count; p++)
+        {
+            int b = partial.localX[p], x = 0, tail = 0;
+            int c = partial.localX[count - 1 - p];
+            for (int q = 0; q < p; q++)
+            {
+                int a = partial.localX[q], d = partial.localX[count - 1 - q];
+                if (posY[a] < posY[b])
+                {
+                    x = max(x, xEnd[a]);
+                }
+                if (posY[d] > posY[c])
+                {
+                    tail = max(tail, xTail[d]);
+                }
+            }
+            xEnd[b] = x + getWidth(partial, b);
+            xTail[c] = tail + getWidth(partial, c);
+            result.width = max(result.width, xEnd[b]);
+        }
+        for (int p = 0; p < count; p++)
+        {
+            int b = partial.localY[p], y = 0, tail = 0;
+            int c = partial.localY[count - 1 - p];
+            for (int q = 0; q < p; q++)
+            {
+                int a = partial.localY[q], d = partial.localY[count - 1 - q];
+                if (posX[a] > posX[b])
+                {
+                    y = max(y, yEnd[a]);
+                }
+                if (posX[d] < posX[c])
+                {
+                    tail = max(tail, yTail[d]);
+                }
+            }
+            yEnd[b] = y + getHeight(partial, b);
+            yTail[c] = tail + getHeight(partial, c);
+            result.height = max(result.height, yEnd[b]);
+        }
+
+        for (int px = 0; px <= count; px++)
+        {
+            for (int py = 0; py <= count; py++)
+            {
+                result.left[px][py] = result.right[px][py] = result.below[px][py] = result.above[px][py] = 0;
+            }
+        }
+        // the block at i in X and j in Y is left of the insertions at px > i and py > j, and so on
+        for (int p = 0; p < count; p++)
+        {
+            int b = partial.localX[p], i = p, j = posY[b];
+            result.left[i + 1][j + 1] = max(result.left[i + 1][j + 1], xEnd[b]);
+            result.right[i][j] = max(result.right[i][j], xTail[b]);
+            result.below[i][j + 1] = max(result.below[i][j + 1], yEnd[b]);
+            result.above[i + 1][j] = max(result.above[i + 1][j], yTail[b]);
+        }
+        for (int px = 0; px <= count; px++)
+        {
+            for (int py = 0; py <= count; py++)
+            {
+                if (px > 0)
+                {
+                    result.left[px][py] = max(result.left[px][py], result.left[px - 1][py]);
+                    result.above[px][py] = max(result.above[px][py], result.above[px - 1][py]);
+                }
+                if (py > 0)
+                {
+                    result.left[px][py] = max(result.left[px][py], result.left[px][py - 1]);
+                    result.below[px][py] = max(result.below[px][py], result.below[px][py - 1]);
+                }
+            }
+        }
+        for (int px = count; px >= 0; px--)
+        {
+            for (int py = count; py >= 0; py--)
+            {
+                if (px < count)
+                {
+                    result.right[px][py] = max(result.right[px][py], result.right[px + 1][py]);
+                    result.below[px][py] = max(result.below[px][py], result.below[px + 1][py]);
+                }
+                if (py < count)
+                {
+                    result.right[px][py] = max(result.right[px][py], result.right[px][py + 1]);
+                    result.above[px][py] = max(result.above[px][py], result.above[px][py + 1]);
+                }
+            }
+        }
+    }
+
+    // symmetry cuts on the insertion of block count at px in X and py in Y
+    bool isCanonical(const Partial &partial, int count, int px, int py) const
+    {
+        if (count == 1)
+        {
+            return px == 1 && py == 1;
+        }
+        int previous = identical[count];
+        if (previous >= 0)
+        {
+            int at = find(partial.localX.begin(), partial.localX.end(), previous) - partial.localX.begin();
+            return px > at;
+        }
+        return true;
+    }
+
+    // whether block i alone fits into the partial below the incumbent, a subset never packs larger than the whole
+    bool fits(const Profile &profile, int count, int i) const
+    {
+        for (const pair<int, int> &shape : dimensions[order[i]])
+        {
+            for (int px = 0; px <= count; px++)
+            {
+                for (int py = 0; py <= count; py++)
+                {
+                    if (profile.cost(px, py, shape.first, shape.second) < bestCost)
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    void record(const Partial &partial, int cost)
+    {
+        lock_guard<mutex> guard(bestLock);
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            best = partial;
+            found = true;
+        }
+    }
+
+    // children of a partial with count blocks that may still beat the incumbent, cheapest first
+    template <class Visit>
+    void expand(Partial &partial, int count, const Profile &profile, const Visit &visit)
+    {
+        struct Child
+        {
+            int cost, px, py, shape;
+            bool operator<(const Child &other) const
+            {
+                return cost < other.cost;
+            }
+        };
+        vector<Child> children;
+        for (int px = 0; px <= count; px++)
+        {
+            partial.localX.insert(partial.localX.begin() + px, count);
+            for (int py = 0; py <= count; py++)
+            {
+                if (!isCanonical(partial, count, px, py))
+                {
+                    continue;
+                }
+                for (size_t s = 0; s < dimensions[order[count]].size(); s++)
+                {
+                    const pair<int, int> &shape = dimensions[order[count]][s];
+                    int cost = profile.cost(px, py, shape.first, shape.second);
+                    if (cost < bestCost)
+                    {
+                        children.push_back({cost, px, py, static_cast<int>(s)});
+                    }
+                }
+            }
+            partial.localX.erase(partial.localX.begin() + px);
+        }
+        stable_sort(children.begin(), children.end());
+        for (const Child &child : children)
+        {
+            if (child.cost >= bestCost)
+            {
+                break;
+            }
+            partial.localX.insert(partial.localX.begin() + child.px, count);
+            partial.localY.insert(partial.localY.begin() + child.py, count);
+            partial.shapes[count] = child.shape;
+            visit(partial, child.cost);
+            partial.localY.erase(partial.localY.begin() + child.py);
+            partial.localX.erase(partial.localX.begin() + child.px);
+        }
+    }
+
+    void search(Partial &partial, int count, long long &visited)
+    {
+        if (expired || bestCost <= lowerBound)
+        {
+            return;
+        }
+        if ((++visited & 4095) == 0 && (API::task_cancel || chrono::steady_clock::now() > deadline))
+        {
+            expired = true;
+            return;
+        }
+        Profile current;
+        profile(partial, count, current);
+        // the next block is bounded by its own children, every later one must fit as well
+        for (int i = count + 1; i < numNodes; i++)
+        {
+            if (!fits(current, count, i))
+            {
+                return;
+            }
+        }
+        expand(partial, count, current, [&](Partial &child, int cost)
+               {
+            if (count + 1 == numNodes)
+            {
+                record(child, cost);
+                return;
+            }
+            search(child, count + 1, visited); });
+    }
+
+public:
+    ExactSolver(const vector<vector<pair<int, int>>> &dimensions) : dimensions(dimensions), numNodes(dimensions.size()), bestCost(numeric_limits<int>::max()), nodes(0), expired(false)
+    {
+        order.resize(numNodes);
+        double area = 0;
+        int largest = 0;
+        for (int b = 0; b < numNodes; b++)
+        {
+            order[b] = b;
+            area += static_cast<double>(dimensions[b][0].first) * dimensions[b][0].second;
+            int side = numeric_limits<int>::max();
+            for (const pair<int, int> &shape : dimensions[b])
+            {
+                side = min(side, max(shape.first, shape.second));
+            }
+            largest = max(largest, side);
+        }
+        lowerBound = max(largest, static_cast<int>(ceil(sqrt(area) - 1e-9)));
+
+        auto areaOf = [&](int b)
+        { return static_cast<long long>(dimensions[b][0].first) * dimensions[b][0].second; };
+        stable_sort(order.begin(), order.end(), [&](int a, int b)
+                    { return areaOf(a) > areaOf(b) || (areaOf(a) == areaOf(b) && dimensions[a] < dimensions[b]); });
+        // the first two blocks are ordered by the geometric symmetry already
+        identical.assign(numNodes, -1);
+        for (int i = 3; i < numNodes; i++)
+        {
+            if (dimensions[order[i]] == dimensions[order[i - 1]])
+            {
+                identical[i] = i - 1;
+            }
+        }
+    }
+
+    inline int getLowerBound() const
+    {
+        return lowerBound;
+    }
+
+    /*
+     * Search for a floorplan cheaper than incumbent, returns whether the search
+     * finished, proving the best cost optimal, before the time limit.
+     */
+    bool solve(int incumbent, ThreadPool &pool, double timeLimit)
+    {
+        bestCost = incumbent;
+        deadline = chrono::steady_clock::now() + chrono::milliseconds(static_cast<long long>(timeLimit * 1000));
+        if (numNodes == 0 || numNodes > EXACT_MAX_BLOCKS)
+        {
+            return numNodes == 0;
+        }
+
+        // every partial of the first few blocks is a subtree of its own
+        vector<Partial> subtrees;
+        vector<int> subtreeCosts;
+        int depth = min(numNodes, EXACT_SPLIT_DEPTH);
+        Partial root;
+        root.shapes.assign(numNodes, 0);
+        function<void(Partial &, int)> split = [&](Partial &partial, int count)
+        {
+            Profile current;
+            profile(partial, count, current);
+            expand(partial, count, current, [&](Partial &child, int cost)
+                   {
+                if (count + 1 == numNodes)
+                {
+                    record(child, cost);
+                }
+                else if (count + 1 == depth)
+                {
+                    subtrees.push_back(child);
+                    subtreeCosts.push_back(cost);
+                }
+                else
+                {
+                    split(child, count + 1);
+                } });
+        };
+        split(root, 0);
+
+        // most promising subtrees first, so the incumbent drops early
+        vector<int> byCost(subtrees.size());
+        for (size_t i = 0; i < byCost.size(); i++)
+        {
+            byCost[i] = static_cast<int>(i);
+        }
+        sort(byCost.begin(), byCost.end(), [&](int a, int b)
+             { return subtreeCosts[a] < subtreeCosts[b]; });
+        pool.parallelFor(static_cast<int>(subtrees.size()), 1, [&](int first, int last)
+                         {
+            long long visited = 0;
+            for (int i = first; i < last; i++)
+            {
+                int s = byCost[i];
+                if (subtreeCosts[s] < bestCost)
+                {
+                    search(subtrees[s], depth, visited);
+                }
+            }
+            nodes += visited; });
+        return !expired;
+    }
+
+    inline int getBestCost() const
+    {
+        return bestCost;
+    }
+
+    inline long long getNodes() const
+    {
+        return nodes;
+    }
+
+    // whether a floorplan cheaper than the incumbent was found
+    inline bool hasSolution() const
+    {
+        return found;
+    }
+
+    // the best floorplan found as a sequence pair over the blocks, and its shapes
+    void getSolution(CompactSequencePair &state, vector<int> &shapes) const
+    {
+        state = CompactSequencePair(numNodes);
+        shapes.assign(numNodes, 0);
+        for (int p = 0; p < numNodes; p++)
+        {
+            state.posX[order[best.localX[p]]] = p;
+            state.posY[order[best.localY[p]]] = p;
+        }
+        for (int i = 0; i < numNodes; i++)
+        {
+            int b = order[i];
+            shapes[b] = best.shapes[i];
+            state.setShape(b, dimensions[b][best.shapes[i]].first, dimensions[b][best.shapes[i]].second);
+        }
+        state.updateSequences();
+    }
+};
+
+#endif // EXACTSOLVER_HPP
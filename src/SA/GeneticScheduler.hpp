@@ -0,0 +1,318 @@
+#ifndef GENETICSCHEDULER_HPP
+#define GENETICSCHEDULER_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <random>
+#include <cmath>
+#include <iomanip>
+#include <chrono>
+#include <limits>
+
+#include "Macro.hpp"
+#include "SchedulerBase.hpp"
+#include "CompactSequencePair.hpp"
+#include "ThreadPool.hpp"
+#include "CpuTopology.hpp"
+#include "../api.h"
+
+using namespace std;
+
+// individuals kept unchanged from one generation to the next
+const int GA_ELITE = 2;
+// individuals drawn per tournament
+const int GA_TOURNAMENT = 3;
+
+/*
+ * Population of sequence pairs bred by order crossover on both sequences and
+ * uniform crossover on the shapes, then mutated with one of the four moves.
+ * Parents are picked by tournament. Every child is bred and evaluated on the
+ * thread pool with its own generator, and the best individuals pass on unchanged,
+ * optionally polished first by a short Metropolis walk at the cooling temperature.
+ */
+class GeneticScheduler : public SchedulerBase
+{
+private:
+    struct Individual
+    {
+        CompactSequencePair state;
+        vector<int> shapes;
+        double cost = numeric_limits<double>::infinity();
+    };
+
+    vector<Individual> population, offspring;
+    Individual best;
+    double temperature;
+
+    inline void setShape(Individual &individual, int v, int shapeIndex) const
+    {
+        individual.shapes[v] = shapeIndex;
+        individual.state.setShape(v, macroDimensions[v][shapeIndex].first, macroDimensions[v][shapeIndex].second);
+    }
+
+    void randomize(Individual &individual, mt19937 &generator) const
+    {
+        individual.state = CompactSequencePair(numNodes);
+        individual.shapes.resize(numNodes);
+        shuffle(individual.state.seqX.begin(), individual.state.seqX.end(), generator);
+        shuffle(individual.state.seqY.begin(), individual.state.seqY.end(), generator);
+        for (int i = 0; i < numNodes; i++)
+        {
+            individual.state.posX[individual.state.seqX[i]] = i;
+            individual.state.posY[individual.state.seqY[i]] = i;
+            setShape(individual, i, uniform_int_distribution<int>(0, macroDimensions[i].size() - 1)(generator));
+        }
+        individual.cost = individual.state.evaluate();
+    }
+
+    /*
+     * Order crossover: the child keeps the slice [first, last) of one parent and takes
+     * the other blocks in the order of the other parent, starting after the slice.
+     */
+    void orderCrossover(const vector<int> &seq1, const vector<int> &seq2, vector<int> &child, vector<int> &pos, vector<char> &taken, mt19937 &generator) const
+    {
+        uniform_int_distribution<int> pick(0, numNodes);
+        int first = pick(generator), last = pick(generator);
+        if (first > last)
+        {
+            swap(first, last);
+        }
+        fill(taken.begin(), taken.end(), 0);
+        for (int i = first; i < last; i++)
+        {
+            child[i] = seq1[i];
+            taken[seq1[i]] = 1;
+        }
+        int p = last % numNodes;
+        for (int j = 0; j < numNodes; j++)
+        {
+            int b = seq2[(last + j) % numNodes];
+            if (taken[b])
+            {
+                continue;
+            }
+            child[p] = b;
+            p = (p + 1) % numNodes;
+        }
+        for (int i = 0; i < numNodes; i++)
+        {
+            pos[child[i]] = i;
+        }
+    }
+
+    void mutate(Individual &individual, mt19937 &generator) const
+    {
+        uniform_int_distribution<int> pickNode(0, numNodes - 1);
+        int v1 = pickNode(generator), v2 = pickNode(generator);
+        switch (uniform_int_distribution<int>(0, 3)(generator))
+        {
+        case 0:
+            individual.state.swapX(v1, v2);
+            break;
+        case 1:
+            individual.state.swapY(v1, v2);
+            break;
+        case 2:
+            setShape(individual, v1, uniform_int_distribution<int>(0, macroDimensions[v1].size() - 1)(generator));
+            break;
+        default:
+            individual.state.swapBoth(v1, v2);
+            break;
+        }
+    }
+
+    int tournament(mt19937 &generator) const
+    {
+        uniform_int_distribution<int> pick(0, population.size() - 1);
+        int winner = pick(generator);
+        for (int i = 1; i < GA_TOURNAMENT; i++)
+        {
+            int challenger = pick(generator);
+            if (population[challenger].cost < population[winner].cost)
+            {
+                winner = challenger;
+            }
+        }
+        return winner;
+    }
+
+    void breed(Individual &child, mt19937 &generator, vector<char> &taken) const
+    {
+        const Individual &mother = population[tournament(generator)];
+        const Individual &father = population[tournament(generator)];
+        child.state = mother.state;
+        child.shapes = mother.shapes;
+        orderCrossover(mother.state.seqX, father.state.seqX, child.state.seqX, child.state.posX, taken, generator);
+        orderCrossover(mother.state.seqY, father.state.seqY, child.state.seqY, child.state.posY, taken, generator);
+        bernoulli_distribution coin(0.5);
+        for (int i = 0; i < numNodes; i++)
+        {
+            if (coin(generator))
+            {
+                setShape(child, i, father.shapes[i]);
+            }
+        }
+        mutate(child, generator);
+        child.cost = child.state.evaluate();
+    }
+
+    // Metropolis walk of the given moves, keeping the best state seen
+    void polish(Individual &individual, int moves, mt19937 &generator) const
+    {
+        Individual current = individual;
+        uniform_real_distribution<double> uniform(0, 1);
+        for (int m = 0; m < moves; m++)
+        {
+            Individual candidate = current;
+            mutate(candidate, generator);
+            candidate.cost = candidate.state.evaluate();
+            if (candidate.cost <= current.cost || exp((current.cost - candidate.cost) / temperature) > uniform(generator))
+            {
+                swap(current, candidate);
+                if (current.cost < individual.cost)
+                {
+                    individual = current;
+                }
+            }
+        }
+    }
+
+public:
+    GeneticScheduler(vector<Macro> &macros, float minAspectRatio, float maxAspectRatio, int k = 7, int timeLimit = 10)
+        : SchedulerBase(macros, minAspectRatio, maxAspectRatio, k, timeLimit)
+    {
+        best.state = CompactSequencePair(numNodes);
+        best.shapes = macroDimensionsIndex;
+        for (int i = 0; i < numNodes; i++)
+        {
+            setShape(best, i, 0);
+        }
+        best.cost = best.state.evaluate();
+    }
+
+    inline double evaluateState()
+    {
+        return best.cost;
+    }
+
+    void run(ostream &logFile, const API::Parameters &parm)
+    {
+        int populationSize = max(GA_ELITE + 1, parm.populationSize);
+        int generations = max(1, parm.generations);
+        temperature = parm.temperature;
+        int threads = max(1, parm.threads);
+        CpuTopology topology;
+        ThreadPool pool(threads, parm.pinThreads ? topology.getPlacements(threads) : vector<int>());
+        logFile << "populationSize: " << populationSize << ", generations: " << generations << ", polishMoves: " << parm.polishMoves
+                << ", threads: " << pool.size() << endl;
+        logFile << "Initial cost: " << best.cost << endl;
+        logFile << setw(10) << "Time" << setw(12) << "Generation" << setw(20) << "Cost" << setw(20) << "Mean" << endl;
+
+        // one generator per individual slot, reseeded from the scheduler every generation
+        vector<mt19937> generators(populationSize);
+        auto reseed = [&]()
+        {
+            for (int i = 0; i < populationSize; i++)
+            {
+                generators[i].seed(generator());
+            }
+        };
+
+        reseed();
+        population.resize(populationSize);
+        offspring.resize(populationSize);
+        population[0] = best;
+        pool.parallelFor(populationSize - 1, 4, [&](int first, int last)
+                         {
+            for (int i = first; i < last; i++)
+            {
+                randomize(population[i + 1], generators[i + 1]);
+            } });
+
+        long long evaluations = populationSize;
+        auto begin = chrono::high_resolution_clock::now();
+        auto byCost = [](const Individual &a, const Individual &b)
+        { return a.cost < b.cost; };
+        for (int generation = 0; generation < generations; generation++)
+        {
+            partial_sort(population.begin(), population.begin() + GA_ELITE, population.end(), byCost);
+            reseed();
+            if (parm.polishMoves > 0)
+            {
+                pool.parallelFor(GA_ELITE, 1, [&](int first, int last)
+                                 {
+                    for (int i = first; i < last; i++)
+                    {
+                        polish(population[i], parm.polishMoves, generators[i]);
+                    } });
+                evaluations += static_cast<long long>(GA_ELITE) * parm.polishMoves;
+                sort(population.begin(), population.begin() + GA_ELITE, byCost);
+            }
+            if (population[0].cost < best.cost)
+            {
+                best = population[0];
+            }
+
+            for (int i = 0; i < GA_ELITE; i++)
+            {
+                offspring[i] = population[i];
+            }
+            pool.parallelFor(populationSize - GA_ELITE, 4, [&](int first, int last)
+                             {
+                vector<char> taken(numNodes);
+                for (int i = first + GA_ELITE; i < last + GA_ELITE; i++)
+                {
+                    breed(offspring[i], generators[i], taken);
+                } });
+            evaluations += populationSize - GA_ELITE;
+            swap(population, offspring);
+            temperature *= parm.coolingRate;
+
+            double mean = 0;
+            for (const Individual &individual : population)
+            {
+                mean += individual.cost;
+            }
+            logFile << setw(10) << getElapsed() << setw(12) << generation + 1 << setw(20) << best.cost << setw(20) << mean / populationSize << endl;
+
+            API::task_progress = (float)(generation + 1) / generations;
+            if (API::task_cancel)
+            {
+                logFile << "Task cancelled" << endl;
+                break;
+            }
+            if (hasTimeExpired())
+            {
+                logFile << "Time expired" << endl;
+                break;
+            }
+        }
+        for (const Individual &individual : population)
+        {
+            if (individual.cost < best.cost)
+            {
+                best = individual;
+            }
+        }
+
+        double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count();
+        if (seconds > 0)
+        {
+            logFile << "Evaluations per second: " << evaluations / seconds << endl;
+        }
+        logFile << "Result: " << best.cost << endl;
+    }
+
+    void saveFloorplan(string filename)
+    {
+        macroDimensionsIndex = best.shapes;
+        vector<int> xs(numNodes), ys(numNodes);
+        int width = best.state.findWidth(&xs);
+        int height = best.state.findHeight(&ys);
+        writeFloorplan(filename, xs, ys, width, height);
+    }
+};
+
+#endif // GENETICSCHEDULER_HPP
@@ -0,0 +1,63 @@
+#ifndef EDGEPROPERTYSTORE_HPP
+#define EDGEPROPERTYSTORE_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <type_traits>
+
+#include "EdgeProperty.hpp"
+
+using namespace std;
+
+// Define a structure holding the per-edge properties of a graph
+template <class EdgeData, bool IsEmpty = is_empty<EdgeData>::value>
+class EdgePropertyStore
+{
+private:
+    EdgeProperty<EdgeData> emptyEdgeProperty = EdgeProperty<EdgeData>();
+
+    vector<unordered_map<int, EdgeProperty<EdgeData>>> edgePropertiesMap;
+
+public:
+    EdgePropertyStore(int numNodes) : edgePropertiesMap(numNodes) {}
+
+    // Method to mark an edge as present with an empty property
+    void add(int source, int target)
+    {
+        edgePropertiesMap[source][target] = emptyEdgeProperty;
+    }
+
+    void set(int source, int target, const EdgeProperty<EdgeData> &property)
+    {
+        edgePropertiesMap[source][target] = property;
+    }
+
+    EdgeProperty<EdgeData> get(int source, int target) const
+    {
+        auto it = edgePropertiesMap[source].find(target);
+        if (it != edgePropertiesMap[source].end())
+        {
+            return it->second;
+        }
+        return emptyEdgeProperty;
+    }
+};
+
+// Empty edge data carries no information, so nothing is stored at all
+template <class EdgeData>
+class EdgePropertyStore<EdgeData, true>
+{
+public:
+    EdgePropertyStore(int) {}
+
+    void add(int, int) {}
+
+    void set(int, int, const EdgeProperty<EdgeData> &) {}
+
+    EdgeProperty<EdgeData> get(int, int) const
+    {
+        return EdgeProperty<EdgeData>();
+    }
+};
+
+#endif // EDGEPROPERTYSTORE_HPP
@@ -8,9 +8,11 @@
 #include <unordered_map>
 #include <set>
 #include <limits>
+#include <cstdint>
 
 #include "VertexProperty.hpp"
 #include "EdgeProperty.hpp"
+#include "EdgePropertyStore.hpp"
 #include "Vertex.hpp"
 #include "NoProperty.hpp"
 
@@ -21,12 +23,23 @@ template <class VertexData, class EdgeData>
 class Graph
 {
 private:
-    EdgeProperty<EdgeData> emptyEdgeProperty = EdgeProperty<EdgeData>();
     VertexProperty<VertexData> emptyVertexProperty = VertexProperty<VertexData>();
 
     vector<map<int, float>> outEdgesList, inEdgesList;
     vector<VertexProperty<VertexData>> vertexPropertiesMap;
-    vector<unordered_map<int, EdgeProperty<EdgeData>>> edgePropertiesMap;
+    EdgePropertyStore<EdgeData> edgePropertiesMap;
+
+    // xor of a key per edge, so it tells whether the edges changed since it was read, weights aside
+    uint64_t structureHash = 0;
+
+    static inline uint64_t edgeKey(int source, int target)
+    {
+        uint64_t x = (static_cast<uint64_t>(source) << 32) ^ static_cast<uint32_t>(target);
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
 
 public:
     // Constructor
@@ -67,9 +80,17 @@ public:
     // Method to add a directed edge
     void addDirectedEdge(int source, int target, float weight)
     {
-        outEdgesList[source][target] = weight;
+        auto inserted = outEdgesList[source].insert(make_pair(target, weight));
+        if (inserted.second)
+        {
+            structureHash ^= edgeKey(source, target);
+        }
+        else
+        {
+            inserted.first->second = weight;
+        }
         inEdgesList[target][source] = weight;
-        edgePropertiesMap[source][target] = emptyEdgeProperty;
+        edgePropertiesMap.add(source, target);
     }
 
     void addDirectedEdge(const Vertex &source, const Vertex &target, float weight)
@@ -77,15 +98,25 @@ public:
         addDirectedEdge(source.getId(), target.getId(), weight);
     }
 
-    // Method to get edge property
-    EdgeProperty<EdgeData> getEdgeProperty(int source, int target) const
+    // Method to remove a directed edge
+    void removeDirectedEdge(int source, int target)
     {
-        auto it = edgePropertiesMap[source].find(target);
-        if (it != edgePropertiesMap[source].end())
+        if (outEdgesList[source].erase(target))
         {
-            return it->second;
+            structureHash ^= edgeKey(source, target);
         }
-        return emptyEdgeProperty;
+        inEdgesList[target].erase(source);
+    }
+
+    void removeDirectedEdge(const Vertex &source, const Vertex &target)
+    {
+        removeDirectedEdge(source.getId(), target.getId());
+    }
+
+    // Method to get edge property
+    EdgeProperty<EdgeData> getEdgeProperty(int source, int target) const
+    {
+        return edgePropertiesMap.get(source, target);
     }
 
     EdgeProperty<EdgeData> getEdgeProperty(const Vertex &source, const Vertex &target) const
@@ -139,7 +170,7 @@ public:
     // Method to set edge property
     void setEdgeProperty(int source, int target, const EdgeProperty<EdgeData> &property)
     {
-        edgePropertiesMap[source][target] = property;
+        edgePropertiesMap.set(source, target, property);
     }
 
     void setEdgeProperty(const Vertex &source, const Vertex &target, const EdgeProperty<EdgeData> &property)
@@ -202,6 +233,22 @@ public:
         return getInEdges(vertex.getId());
     }
 
+    // the edges of a vertex without a copy, for passes run on several threads
+    inline const map<int, float> &getOutEdgeMap(int vertex) const
+    {
+        return outEdgesList[vertex];
+    }
+
+    inline const map<int, float> &getInEdgeMap(int vertex) const
+    {
+        return inEdgesList[vertex];
+    }
+
+    inline uint64_t getStructureHash() const
+    {
+        return structureHash;
+    }
+
     vector<map<int, float>> getAdjacencyList() const
     {
         return outEdgesList;
@@ -213,6 +260,7 @@ public:
         for (const auto &edge : outEdgesList[vertex])
         {
             inEdgesList[edge.first].erase(vertex);
+            structureHash ^= edgeKey(vertex, edge.first);
         }
         outEdgesList[vertex].clear();
 
@@ -220,6 +268,7 @@ public:
         for (const auto &edge : inEdgesList[vertex])
         {
             outEdgesList[edge.first].erase(vertex);
+            structureHash ^= edgeKey(edge.first, vertex);
         }
         inEdgesList[vertex].clear();
     }
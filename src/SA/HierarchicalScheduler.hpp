@@ -0,0 +1,314 @@
+#ifndef HIERARCHICALSCHEDULER_HPP
+#define HIERARCHICALSCHEDULER_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <random>
+#include <cmath>
+#include <iomanip>
+#include <chrono>
+
+#include "Macro.hpp"
+#include "SchedulerBase.hpp"
+#include "CompactSequencePair.hpp"
+#include "SkylineSeeder.hpp"
+#include "ThreadPool.hpp"
+#include "CpuTopology.hpp"
+#include "../api.h"
+
+using namespace std;
+
+// width to height ratios a cluster is floorplanned for, each also offered transposed
+const double CLUSTER_ASPECTS[] = {1.0, 2.0};
+
+/*
+ * Cluster-then-floorplan for designs too large to anneal flat. Blocks are sorted by
+ * area and cut into clusters of clusterSize, so a cluster holds blocks of similar
+ * size, and each cluster anneals its own sequence pair from a skyline seed on the
+ * thread pool. A floorplanned cluster becomes a soft block whose shape options are
+ * its internal floorplans, one per aspect ratio and its transpose, and the clusters
+ * are clustered again for clusterDepth levels. The top level anneals the remaining
+ * clusters; the floorplan is the top level with every cluster expanded in place.
+ */
+class HierarchicalScheduler : public SchedulerBase
+{
+private:
+    // a block or a cluster, with a floorplan of its children for every shape option
+    struct Node
+    {
+        vector<pair<int, int>> shapes;
+        // option of every option turned by 90 degrees
+        vector<int> transposed;
+        vector<int> children;
+        // per option: the option and the offset of every child
+        vector<vector<int>> childShapes, childXs, childYs;
+    };
+
+    vector<Node> nodes;
+    vector<int> top;
+    CompactSequencePair topState;
+    vector<int> topShapes;
+    double bestCost;
+
+    inline long long areaOf(int node) const
+    {
+        return static_cast<long long>(nodes[node].shapes[0].first) * nodes[node].shapes[0].second;
+    }
+
+    /*
+     * Anneal a sequence pair over items with shape options from a skyline seed,
+     * minimising max(width / aspect, height), and keep the best state met.
+     */
+    double anneal(const vector<int> &items, double aspect, CompactSequencePair &state, vector<int> &shapes, mt19937 &chain, const API::Parameters &parm, ostream *logFile = nullptr)
+    {
+        int m = static_cast<int>(items.size());
+        vector<vector<pair<int, int>>> dimensions(m);
+        for (int i = 0; i < m; i++)
+        {
+            dimensions[i] = nodes[items[i]].shapes;
+        }
+        SkylineSeeder(dimensions).run(state, shapes);
+        auto evaluate = [&]()
+        { return max(state.findWidth() / aspect, static_cast<double>(state.findHeight())); };
+        double cost = evaluate(), bestCost = cost;
+        if (logFile)
+        {
+            *logFile << "Initial cost: " << state.evaluate() << endl;
+            *logFile << setw(10) << "Time" << setw(10) << "Steps" << setw(20) << "Cost" << endl;
+        }
+        if (m < 2)
+        {
+            return bestCost;
+        }
+
+        CompactSequencePair best = state;
+        vector<int> bestShapes = shapes;
+        uniform_int_distribution<int> pick(0, m - 1), pickMove(0, 3);
+        uniform_real_distribution<double> uniform(0.0, 1.0);
+        double temperature = parm.temperature;
+        int targetIterations = parm.targetIterations > 0 ? parm.targetIterations : log2(parm.absoluteTemperature / temperature) / log2(parm.coolingRate);
+        long long steps = 0;
+        for (int iteration = 0; iteration < targetIterations && !API::task_cancel; iteration++)
+        {
+            for (int s = 0; s < 2 * m * k; s++)
+            {
+                int v1 = pick(chain);
+                int v2 = pick(chain);
+                if (v1 == v2)
+                {
+                    v2 = (v1 + 1) % m;
+                }
+                int move = pickMove(chain);
+                int originalShape = shapes[v1];
+                if (move == 3 && dimensions[v1].size() == 1)
+                {
+                    move = 2;
+                }
+                switch (move)
+                {
+                case 0:
+                    state.swapX(v1, v2);
+                    break;
+                case 1:
+                    state.swapY(v1, v2);
+                    break;
+                case 2:
+                    state.swapBoth(v1, v2);
+                    break;
+                default:
+                    shapes[v1] = (originalShape + 1 + chain() % (dimensions[v1].size() - 1)) % dimensions[v1].size();
+                    state.setShape(v1, dimensions[v1][shapes[v1]].first, dimensions[v1][shapes[v1]].second);
+                    break;
+                }
+
+                double newCost = evaluate();
+                if (newCost <= cost || exp((cost - newCost) / temperature) > uniform(chain))
+                {
+                    cost = newCost;
+                    if (cost < bestCost)
+                    {
+                        bestCost = cost;
+                        best = state;
+                        bestShapes = shapes;
+                    }
+                    continue;
+                }
+                switch (move)
+                {
+                case 0:
+                    state.swapX(v1, v2);
+                    break;
+                case 1:
+                    state.swapY(v1, v2);
+                    break;
+                case 2:
+                    state.swapBoth(v1, v2);
+                    break;
+                default:
+                    shapes[v1] = originalShape;
+                    state.setShape(v1, dimensions[v1][originalShape].first, dimensions[v1][originalShape].second);
+                    break;
+                }
+            }
+            steps += 2LL * m * k;
+            temperature *= parm.coolingRate;
+            if (logFile)
+            {
+                *logFile << setw(10) << getElapsed() << setw(10) << steps << setw(20) << bestCost << endl;
+                API::task_progress = (float)(iteration + 1) / targetIterations;
+            }
+        }
+        state = best;
+        shapes = bestShapes;
+        return bestCost;
+    }
+
+    // floorplan a cluster for every aspect ratio and record each floorplan and its transpose as options
+    void floorplanCluster(Node &cluster, mt19937 &chain, const API::Parameters &parm)
+    {
+        int m = static_cast<int>(cluster.children.size());
+        for (double aspect : CLUSTER_ASPECTS)
+        {
+            CompactSequencePair state;
+            vector<int> shapes, xs(m), ys(m);
+            anneal(cluster.children, aspect, state, shapes, chain, parm);
+            int width = state.findWidth(&xs);
+            int height = state.findHeight(&ys);
+            int option = static_cast<int>(cluster.shapes.size());
+            cluster.shapes.push_back({width, height});
+            cluster.shapes.push_back({height, width});
+            cluster.transposed.push_back(option + 1);
+            cluster.transposed.push_back(option);
+            cluster.childShapes.push_back(shapes);
+            cluster.childXs.push_back(xs);
+            cluster.childYs.push_back(ys);
+            // mirrored across the diagonal, every child turned as well
+            for (int i = 0; i < m; i++)
+            {
+                shapes[i] = nodes[cluster.children[i]].transposed[shapes[i]];
+            }
+            cluster.childShapes.push_back(shapes);
+            cluster.childXs.push_back(ys);
+            cluster.childYs.push_back(xs);
+        }
+    }
+
+    // place a node with the given option at x, y, down to its blocks
+    void place(int node, int option, int x, int y, vector<int> &xs, vector<int> &ys)
+    {
+        const Node &current = nodes[node];
+        if (current.children.empty())
+        {
+            xs[node] = x;
+            ys[node] = y;
+            macroDimensionsIndex[node] = option;
+            return;
+        }
+        for (size_t i = 0; i < current.children.size(); i++)
+        {
+            place(current.children[i], current.childShapes[option][i], x + current.childXs[option][i], y + current.childYs[option][i], xs, ys);
+        }
+    }
+
+public:
+    HierarchicalScheduler(vector<Macro> &macros, float minAspectRatio, float maxAspectRatio, int k = 7, int timeLimit = 10)
+        : SchedulerBase(macros, minAspectRatio, maxAspectRatio, k, timeLimit), bestCost(0)
+    {
+        nodes.resize(numNodes);
+        for (int b = 0; b < numNodes; b++)
+        {
+            const vector<pair<int, int>> &shapes = macroDimensions[b];
+            nodes[b].shapes = shapes;
+            nodes[b].transposed.resize(shapes.size());
+            for (size_t s = 0; s < shapes.size(); s++)
+            {
+                nodes[b].transposed[s] = find(shapes.begin(), shapes.end(), make_pair(shapes[s].second, shapes[s].first)) - shapes.begin();
+            }
+        }
+    }
+
+    inline double evaluateState()
+    {
+        return bestCost;
+    }
+
+    void run(ostream &logFile, const API::Parameters &parm)
+    {
+        int clusterSize = max(2, parm.clusterSize);
+        int threads = max(1, parm.threads);
+        CpuTopology topology;
+        if (parm.pinThreads)
+        {
+            topology.describe(logFile);
+        }
+        ThreadPool pool(threads, parm.pinThreads ? topology.getPlacements(threads) : vector<int>());
+        logFile << "clusterSize: " << clusterSize << ", clusterDepth: " << parm.clusterDepth << ", threads: " << pool.size() << endl;
+
+        top.resize(numNodes);
+        for (int b = 0; b < numNodes; b++)
+        {
+            top[b] = b;
+        }
+        for (int level = 1; level <= parm.clusterDepth && static_cast<int>(top.size()) > clusterSize && !API::task_cancel; level++)
+        {
+            auto start = chrono::high_resolution_clock::now();
+            stable_sort(top.begin(), top.end(), [&](int a, int b)
+                        { return areaOf(a) > areaOf(b); });
+            int first = static_cast<int>(nodes.size());
+            int numClusters = (static_cast<int>(top.size()) + clusterSize - 1) / clusterSize;
+            nodes.resize(first + numClusters);
+            vector<mt19937> generators(numClusters);
+            for (int c = 0; c < numClusters; c++)
+            {
+                nodes[first + c].children.assign(top.begin() + c * clusterSize, top.begin() + min(static_cast<int>(top.size()), (c + 1) * clusterSize));
+                generators[c].seed(generator());
+            }
+            pool.parallelForStatic(numClusters, [&](int begin, int end)
+                                   {
+                for (int c = begin; c < end; c++)
+                {
+                    floorplanCluster(nodes[first + c], generators[c], parm);
+                } });
+            // whitespace of the square floorplans of the clusters over the area of their children
+            double childArea = 0, clusterArea = 0;
+            for (int node : top)
+            {
+                childArea += areaOf(node);
+            }
+            top.resize(numClusters);
+            for (int c = 0; c < numClusters; c++)
+            {
+                top[c] = first + c;
+                clusterArea += areaOf(first + c);
+            }
+            logFile << "Level " << level << ": " << numClusters << " clusters, whitespace " << 100 * (clusterArea - childArea) / clusterArea << "%, "
+                    << chrono::duration<double>(chrono::high_resolution_clock::now() - start).count() << "s" << endl;
+        }
+
+        logFile << "Top level: " << top.size() << " nodes" << endl;
+        auto start = chrono::high_resolution_clock::now();
+        bestCost = anneal(top, 1.0, topState, topShapes, generator, parm, &logFile);
+        logFile << "Top level: " << chrono::duration<double>(chrono::high_resolution_clock::now() - start).count() << "s" << endl;
+        if (API::task_cancel)
+        {
+            logFile << "Task cancelled" << endl;
+        }
+        logFile << "Result: " << bestCost << endl;
+    }
+
+    void saveFloorplan(string filename)
+    {
+        vector<int> xs(top.size()), ys(top.size()), blockXs(numNodes), blockYs(numNodes);
+        int width = topState.findWidth(&xs);
+        int height = topState.findHeight(&ys);
+        for (size_t i = 0; i < top.size(); i++)
+        {
+            place(top[i], topShapes[i], xs[i], ys[i], blockXs, blockYs);
+        }
+        writeFloorplan(filename, blockXs, blockYs, width, height);
+    }
+};
+
+#endif // HIERARCHICALSCHEDULER_HPP
@@ -0,0 +1,190 @@
+#ifndef ISLANDMODEL_HPP
+#define ISLANDMODEL_HPP
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <thread>
+#include <memory>
+#include <limits>
+#include <chrono>
+#include <functional>
+
+#include "SimulatedAnnealing.hpp"
+#include "CompactSequencePair.hpp"
+#include "Mailbox.hpp"
+#include "CpuTopology.hpp"
+#include "../api.h"
+
+using namespace std;
+
+/*
+ * Islands anneal on their own threads and every few iterations post the best state
+ * they have seen to their neighbours. An island adopts the best state waiting in its
+ * mailboxes when it beats its current one. With a migration interval of 0 the islands
+ * are independent restarts.
+ */
+class IslandModel
+{
+private:
+    struct Migrant
+    {
+        CompactSequencePair state;
+        vector<int> shapeIndices;
+        double cost = numeric_limits<double>::infinity();
+    };
+
+    // islands receiving the states of island i
+    static vector<int> getNeighbors(int i, int numIslands, int topology)
+    {
+        vector<int> neighbors;
+        if (topology == API::RING)
+        {
+            neighbors.push_back((i + 1) % numIslands);
+            return neighbors;
+        }
+        for (int j = 0; j < numIslands; j++)
+        {
+            if (j != i)
+            {
+                neighbors.push_back(j);
+            }
+        }
+        return neighbors;
+    }
+
+public:
+    /*
+     * Create numIslands schedulers and anneal them, return the index of the best one.
+     * Each island builds its scheduler on its own thread, after pinning when
+     * parm.pinThreads is set, so the first touch keeps its memory on the local node.
+     */
+    template <class SchedulerType>
+    static int run(vector<unique_ptr<SchedulerType>> &islands, int numIslands, const function<SchedulerType *()> &createScheduler, ostream &logFile, const API::Parameters &parm)
+    {
+        islands.clear();
+        islands.resize(numIslands);
+        CpuTopology topology;
+        if (parm.pinThreads)
+        {
+            topology.describe(logFile);
+            logFile << "Island cpus:";
+            for (int i = 0; i < numIslands; i++)
+            {
+                logFile << " " << topology.getPlacement(i);
+            }
+            logFile << endl;
+        }
+        vector<unique_ptr<Mailbox<Migrant>>> mailboxes;
+        vector<vector<Mailbox<Migrant> *>> outboxes(numIslands), inboxes(numIslands);
+        for (int i = 0; i < numIslands; i++)
+        {
+            for (int j : getNeighbors(i, numIslands, parm.migrationTopology))
+            {
+                mailboxes.emplace_back(new Mailbox<Migrant>());
+                outboxes[i].push_back(mailboxes.back().get());
+                inboxes[j].push_back(mailboxes.back().get());
+            }
+        }
+
+        // islands share the cores, so a single evaluation stays serial
+        API::Parameters islandParm = parm;
+        islandParm.threads = 1;
+
+        vector<ostringstream> logs(numIslands);
+        vector<double> results(numIslands);
+        vector<int> migrations(numIslands, 0);
+        vector<thread> threads;
+        auto start = chrono::high_resolution_clock::now();
+        for (int i = 0; i < numIslands; i++)
+        {
+            threads.emplace_back([&, i]()
+                                 {
+                if (parm.pinThreads)
+                {
+                    CpuTopology::pin(topology.getPlacement(i));
+                }
+                islands[i].reset(createScheduler());
+                SchedulerType &scheduler = *islands[i];
+                scheduler.setBestTracking(true);
+                Migrant best, incoming, received;
+                auto updateBest = [&](double currentCost)
+                {
+                    // states accepted as a new best between migrations and left again count as well
+                    if (scheduler.getTrackedCost() < best.cost)
+                    {
+                        best.state = scheduler.getTrackedState();
+                        best.shapeIndices = scheduler.getTrackedShapes();
+                        best.cost = scheduler.getTrackedCost();
+                    }
+                    if (currentCost < best.cost)
+                    {
+                        best.state = scheduler.getCompactState();
+                        best.shapeIndices = scheduler.getShapeIndices();
+                        best.cost = currentCost;
+                    }
+                };
+                auto migrate = [&](double &currentCost)
+                {
+                    updateBest(currentCost);
+                    // a full mailbox drops the state instead of waiting
+                    for (Mailbox<Migrant> *outbox : outboxes[i])
+                    {
+                        outbox->push(best);
+                    }
+                    received.cost = currentCost;
+                    for (Mailbox<Migrant> *inbox : inboxes[i])
+                    {
+                        while (inbox->pop(incoming))
+                        {
+                            if (incoming.cost < received.cost)
+                            {
+                                swap(received, incoming);
+                            }
+                        }
+                    }
+                    if (received.cost < currentCost)
+                    {
+                        scheduler.loadCompactState(received.state, received.shapeIndices);
+                        currentCost = received.cost;
+                        migrations[i]++;
+                    }
+                };
+                SA::run(scheduler, logs[i], islandParm, migrate);
+                results[i] = scheduler.computeCost();
+                // the island ends on the best state it met
+                updateBest(results[i]);
+                if (best.cost < results[i])
+                {
+                    scheduler.loadCompactState(best.state, best.shapeIndices);
+                    results[i] = scheduler.computeCost();
+                }
+                scheduler.setBestTracking(false); });
+        }
+        for (thread &t : threads)
+        {
+            t.join();
+        }
+        double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+
+        int bestIsland = 0;
+        double total = 0;
+        for (int i = 0; i < numIslands; i++)
+        {
+            logFile << "Island " << i << ":" << endl
+                    << logs[i].str();
+            logFile << "Island " << i << " result: " << results[i] << ", states adopted: " << migrations[i] << endl;
+            total += results[i];
+            if (results[i] < results[bestIsland])
+            {
+                bestIsland = i;
+            }
+        }
+        logFile << "Islands: " << numIslands << ", best: " << results[bestIsland] << ", mean: " << total / numIslands
+                << ", wall time: " << seconds << "s" << endl;
+
+        return bestIsland;
+    }
+};
+
+#endif // ISLANDMODEL_HPP
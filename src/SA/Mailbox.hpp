@@ -0,0 +1,66 @@
+#ifndef MAILBOX_HPP
+#define MAILBOX_HPP
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+using namespace std;
+
+/*
+ * Bounded single-producer single-consumer queue. Neither side ever waits: push fails
+ * on a full mailbox and pop fails on an empty one. The slots are preallocated, so
+ * values of a fixed size are copied without allocating once every slot was used.
+ */
+template <class T>
+class Mailbox
+{
+private:
+    vector<T> slots;
+    size_t mask;
+
+    // head is written by the consumer, tail by the producer, on separate cache lines
+    char padding[64];
+    atomic<size_t> head;
+    char headPadding[64 - sizeof(atomic<size_t>)];
+    atomic<size_t> tail;
+
+public:
+    // capacity is rounded up to a power of two
+    Mailbox(size_t capacity = 4) : head(0), tail(0)
+    {
+        size_t size = 1;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    bool push(const T &value)
+    {
+        size_t t = tail.load(memory_order_relaxed);
+        if (t - head.load(memory_order_acquire) == slots.size())
+        {
+            return false;
+        }
+        slots[t & mask] = value;
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+
+    bool pop(T &value)
+    {
+        size_t h = head.load(memory_order_relaxed);
+        if (h == tail.load(memory_order_acquire))
+        {
+            return false;
+        }
+        value = slots[h & mask];
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+};
+
+#endif // MAILBOX_HPP
@@ -0,0 +1,436 @@
+#ifndef MULTILEVELSCHEDULER_HPP
+#define MULTILEVELSCHEDULER_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+
+#include "Macro.hpp"
+#include "SchedulerBase.hpp"
+#include "CompactSequencePair.hpp"
+#include "SkylineSeeder.hpp"
+#include "SimulatedAnnealing.hpp"
+#include "../api.h"
+
+using namespace std;
+
+// shape options kept for a composite block, spread over its Pareto front
+const int MULTILEVEL_SHAPES = 8;
+
+/*
+ * Compact sequence pair over the blocks of one level of a multilevel run, driven by
+ * SA::run. The blocks come with their shape options, the move budget of an iteration
+ * is set by the caller for short refinement passes, and the best state met is kept, as a pass
+ * starts from a projected floorplan it should not end above.
+ */
+class LevelScheduler : public SchedulerBase
+{
+private:
+    CompactSequencePair state, bestState;
+    vector<int> bestShapes;
+    double bestCost, lastCost;
+    int moveBudget;
+
+    Moves previousMove;
+    pair<int, int> previousIndices;
+
+    inline void setShape(int v, int shapeIndex)
+    {
+        macroDimensionsIndex[v] = shapeIndex;
+        state.setShape(v, getWidth(v), getHeight(v));
+    }
+
+    inline void undo()
+    {
+        switch (previousMove)
+        {
+        case M1:
+            state.swapX(previousIndices.first, previousIndices.second);
+            break;
+        case M2:
+            state.swapY(previousIndices.first, previousIndices.second);
+            break;
+        case M3:
+            setShape(previousIndices.first, previousIndices.second);
+            break;
+        case M4:
+            state.swapBoth(previousIndices.first, previousIndices.second);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+public:
+    LevelScheduler(const vector<vector<pair<int, int>>> &dimensions, int k, int moveBudget)
+        : SchedulerBase(dimensions, k), state(numNodes), moveBudget(moveBudget), previousMove(M1), previousIndices(0, 0)
+    {
+        for (int i = 0; i < numNodes; i++)
+        {
+            setShape(i, 0);
+        }
+        bestState = state;
+        bestShapes = macroDimensionsIndex;
+        bestCost = lastCost = state.evaluate();
+    }
+
+    void loadState(const CompactSequencePair &newState, const vector<int> &shapes)
+    {
+        state = newState;
+        for (int i = 0; i < numNodes; i++)
+        {
+            setShape(i, shapes[i]);
+        }
+        bestState = state;
+        bestShapes = macroDimensionsIndex;
+        bestCost = lastCost = state.evaluate();
+    }
+
+    // the best state met and its shapes
+    inline const CompactSequencePair &getState() const
+    {
+        return bestState;
+    }
+
+    inline const vector<int> &getBestShapes() const
+    {
+        return bestShapes;
+    }
+
+    inline double getBestCost() const
+    {
+        return bestCost;
+    }
+
+    // event handlers
+    inline void makeRandomModification()
+    {
+        movesCount++;
+        if (movesCount > moveBudget)
+        {
+            run = false;
+        }
+        if (numNodes < 2)
+        {
+            return;
+        }
+        int v1 = getRandomNumber(0, numNodes - 1);
+        int v2 = getRandomNumber(0, numNodes - 2);
+        if (v2 >= v1)
+        {
+            v2++;
+        }
+        int move = getRandomNumber(0, NUM_MOVES - 1);
+        if (move == M3 && macroDimensions[v1].size() == 1)
+        {
+            move = M4;
+        }
+        previousMove = static_cast<Moves>(move);
+        previousIndices = {v1, v2};
+        switch (move)
+        {
+        case M1:
+            state.swapX(v1, v2);
+            break;
+        case M2:
+            state.swapY(v1, v2);
+            break;
+        case M3:
+            previousIndices = {v1, macroDimensionsIndex[v1]};
+            setShape(v1, (macroDimensionsIndex[v1] + getRandomNumber(1, static_cast<int>(macroDimensions[v1].size()) - 1)) % macroDimensions[v1].size());
+            break;
+        default:
+            state.swapBoth(v1, v2);
+            break;
+        }
+    }
+
+    inline double evaluateState()
+    {
+        lastCost = state.evaluate();
+        return lastCost;
+    }
+
+    // the state just evaluated reached the best cost of SA::run
+    inline void accept()
+    {
+        if (lastCost < bestCost)
+        {
+            bestCost = lastCost;
+            bestState = state;
+            bestShapes = macroDimensionsIndex;
+        }
+    }
+
+    inline void reject()
+    {
+        rejectCount++;
+        undo();
+    }
+};
+
+/*
+ * V-cycle for large designs. Blocks are sorted by area and merged in pairs into
+ * composite blocks, side by side or stacked, keeping the Pareto front of the
+ * composite shapes, until at most multilevelSize blocks are left. The coarsest
+ * level is annealed from a skyline seed with the full schedule. Every finer level
+ * starts from the coarser floorplan projected onto it: the two halves of a composite
+ * take its place next to each other in both sequences, which packs them exactly as
+ * the composite, and a short low temperature SA::run pass refines it.
+ */
+class MultilevelScheduler : public SchedulerBase
+{
+private:
+    // how a composite option is built: the option of each half, stacked or side by side
+    struct Merge
+    {
+        bool stacked;
+        int first, second;
+    };
+
+    struct Level
+    {
+        vector<vector<pair<int, int>>> dimensions;
+        // halves of every composite in the finer level, second is -1 for a block carried over
+        vector<pair<int, int>> halves;
+        vector<vector<Merge>> merges;
+    };
+
+    vector<Level> levels;
+    CompactSequencePair state;
+    double bestCost;
+
+    static long long minArea(const vector<pair<int, int>> &shapes)
+    {
+        long long area = numeric_limits<long long>::max();
+        for (const pair<int, int> &shape : shapes)
+        {
+            area = min(area, static_cast<long long>(shape.first) * shape.second);
+        }
+        return area;
+    }
+
+    // the next coarser level, pairing blocks of similar area
+    Level coarsen(const vector<vector<pair<int, int>>> &dimensions) const
+    {
+        int count = static_cast<int>(dimensions.size());
+        vector<int> byArea(count);
+        for (int i = 0; i < count; i++)
+        {
+            byArea[i] = i;
+        }
+        stable_sort(byArea.begin(), byArea.end(), [&](int a, int b)
+                    { return minArea(dimensions[a]) > minArea(dimensions[b]); });
+
+        Level level;
+        for (int p = 0; p < count; p += 2)
+        {
+            int a = byArea[p];
+            vector<pair<int, int>> shapes;
+            vector<Merge> merges;
+            if (p + 1 == count)
+            {
+                level.halves.push_back({a, -1});
+                for (size_t s = 0; s < dimensions[a].size(); s++)
+                {
+                    shapes.push_back(dimensions[a][s]);
+                    merges.push_back({false, static_cast<int>(s), -1});
+                }
+                level.dimensions.push_back(shapes);
+                level.merges.push_back(merges);
+                continue;
+            }
+            int b = byArea[p + 1];
+            level.halves.push_back({a, b});
+
+            struct Candidate
+            {
+                int width, height;
+                Merge merge;
+            };
+            vector<Candidate> candidates;
+            for (size_t sa = 0; sa < dimensions[a].size(); sa++)
+            {
+                for (size_t sb = 0; sb < dimensions[b].size(); sb++)
+                {
+                    const pair<int, int> &da = dimensions[a][sa], &db = dimensions[b][sb];
+                    candidates.push_back({da.first + db.first, max(da.second, db.second), {false, static_cast<int>(sa), static_cast<int>(sb)}});
+                    candidates.push_back({max(da.first, db.first), da.second + db.second, {true, static_cast<int>(sa), static_cast<int>(sb)}});
+                }
+            }
+            // narrowest first, and of the same width the lowest, then only shapes lower than every narrower one
+            sort(candidates.begin(), candidates.end(), [](const Candidate &x, const Candidate &y)
+                 { return x.width < y.width || (x.width == y.width && x.height < y.height); });
+            vector<Candidate> front;
+            for (const Candidate &candidate : candidates)
+            {
+                if (front.empty() || candidate.height < front.back().height)
+                {
+                    front.push_back(candidate);
+                }
+            }
+            int kept = min(static_cast<int>(front.size()), MULTILEVEL_SHAPES);
+            for (int i = 0; i < kept; i++)
+            {
+                const Candidate &candidate = front[kept > 1 ? i * (static_cast<int>(front.size()) - 1) / (kept - 1) : 0];
+                shapes.push_back({candidate.width, candidate.height});
+                merges.push_back(candidate.merge);
+            }
+            level.dimensions.push_back(shapes);
+            level.merges.push_back(merges);
+        }
+        return level;
+    }
+
+    // the floorplan of a level laid out over the blocks of the finer one
+    static void project(const Level &level, const CompactSequencePair &coarse, const vector<int> &coarseShapes, const vector<vector<pair<int, int>>> &finerDimensions,
+                        CompactSequencePair &fine, vector<int> &fineShapes)
+    {
+        int count = static_cast<int>(finerDimensions.size());
+        fine = CompactSequencePair(count);
+        fineShapes.assign(count, 0);
+        int px = 0, py = 0;
+        for (int p = 0; p < coarse.size(); p++)
+        {
+            // side by side: first left of second, stacked: first below second
+            int c = coarse.seqX[p];
+            const Merge &merge = level.merges[c][coarseShapes[c]];
+            int a = level.halves[c].first, b = level.halves[c].second;
+            if (b < 0)
+            {
+                fine.posX[a] = px++;
+            }
+            else if (merge.stacked)
+            {
+                fine.posX[b] = px++;
+                fine.posX[a] = px++;
+            }
+            else
+            {
+                fine.posX[a] = px++;
+                fine.posX[b] = px++;
+            }
+
+            c = coarse.seqY[p];
+            a = level.halves[c].first, b = level.halves[c].second;
+            fine.posY[a] = py++;
+            if (b >= 0)
+            {
+                fine.posY[b] = py++;
+            }
+        }
+        for (int c = 0; c < coarse.size(); c++)
+        {
+            const Merge &merge = level.merges[c][coarseShapes[c]];
+            fineShapes[level.halves[c].first] = merge.first;
+            if (level.halves[c].second >= 0)
+            {
+                fineShapes[level.halves[c].second] = merge.second;
+            }
+        }
+        fine.updateSequences();
+        for (int i = 0; i < count; i++)
+        {
+            fine.setShape(i, finerDimensions[i][fineShapes[i]].first, finerDimensions[i][fineShapes[i]].second);
+        }
+    }
+
+public:
+    MultilevelScheduler(vector<Macro> &macros, float minAspectRatio, float maxAspectRatio, int k = 7, int timeLimit = 10)
+        : SchedulerBase(macros, minAspectRatio, maxAspectRatio, k, timeLimit), state(numNodes), bestCost(0)
+    {
+    }
+
+    inline double evaluateState()
+    {
+        return bestCost;
+    }
+
+    void run(ostream &logFile, const API::Parameters &parm)
+    {
+        int coarsest = max(2, parm.multilevelSize);
+        logFile << "multilevelSize: " << coarsest << ", refineMoves: " << parm.refineMoves << endl;
+
+        auto start = chrono::high_resolution_clock::now();
+        const vector<vector<pair<int, int>>> *finer = &macroDimensions;
+        while (static_cast<int>(finer->size()) > coarsest)
+        {
+            levels.push_back(coarsen(*finer));
+            finer = &levels.back().dimensions;
+            // whitespace of the smallest composite shapes over the area of the blocks
+            double area = 0, composite = 0;
+            for (const vector<pair<int, int>> &shapes : macroDimensions)
+            {
+                area += minArea(shapes);
+            }
+            for (const vector<pair<int, int>> &shapes : *finer)
+            {
+                composite += minArea(shapes);
+            }
+            logFile << "Level " << levels.size() << ": " << finer->size() << " blocks, whitespace " << 100 * (composite - area) / composite << "%" << endl;
+        }
+        logFile << "Coarsening: " << chrono::duration<double>(chrono::high_resolution_clock::now() - start).count() << "s" << endl;
+
+        // the coarsest level anneals with the full schedule from a skyline packing
+        CompactSequencePair current;
+        vector<int> shapes;
+        SkylineSeeder(*finer).run(current, shapes);
+        {
+            LevelScheduler scheduler(*finer, k, 2 * static_cast<int>(finer->size()) * k);
+            scheduler.loadState(current, shapes);
+            SA::run(scheduler, logFile, parm);
+            current = scheduler.getState();
+            shapes = scheduler.getBestShapes();
+            logFile << "Level " << levels.size() << " cost: " << scheduler.getBestCost() << endl;
+        }
+
+        // finer levels refine the projected floorplan with short low temperature passes, a cancelled run only projects
+        API::Parameters refine = parm;
+        refine.targetIterations = 1;
+        refine.temperature = parm.absoluteTemperature / parm.coolingRate;
+        for (int l = static_cast<int>(levels.size()) - 1; l >= 0; l--)
+        {
+            auto levelStart = chrono::high_resolution_clock::now();
+            const vector<vector<pair<int, int>>> &dimensions = l > 0 ? levels[l - 1].dimensions : macroDimensions;
+            CompactSequencePair projected;
+            vector<int> projectedShapes;
+            project(levels[l], current, shapes, dimensions, projected, projectedShapes);
+
+            LevelScheduler scheduler(dimensions, 1, parm.refineMoves);
+            scheduler.loadState(projected, projectedShapes);
+            double projectedCost = scheduler.getBestCost();
+            if (parm.refineMoves > 0 && !API::task_cancel)
+            {
+                ostream discard(nullptr);
+                SA::run(scheduler, discard, refine);
+            }
+            current = scheduler.getState();
+            shapes = scheduler.getBestShapes();
+            logFile << "Level " << l << ": projected " << projectedCost << ", refined " << scheduler.getBestCost() << ", "
+                    << chrono::duration<double>(chrono::high_resolution_clock::now() - levelStart).count() << "s" << endl;
+        }
+        if (API::task_cancel)
+        {
+            logFile << "Task cancelled" << endl;
+        }
+
+        state = current;
+        macroDimensionsIndex = shapes;
+        bestCost = state.evaluate();
+        logFile << "Result: " << bestCost << endl;
+    }
+
+    void saveFloorplan(string filename)
+    {
+        vector<int> xs(numNodes), ys(numNodes);
+        int width = state.findWidth(&xs);
+        int height = state.findHeight(&ys);
+        writeFloorplan(filename, xs, ys, width, height);
+    }
+};
+
+#endif // MULTILEVELSCHEDULER_HPP
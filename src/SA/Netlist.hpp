@@ -0,0 +1,230 @@
+#ifndef NETLIST_HPP
+#define NETLIST_HPP
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <climits>
+
+using namespace std;
+
+/*
+ * Nets over the blocks and their half-perimeter wirelength, with every pin at the
+ * centre of its block. Pin positions are kept doubled, 2x + w and 2y + h, so they
+ * stay integers. The bounding box of every net is cached for the pin positions it
+ * was computed from; an update compares the new pins with those, and only the nets
+ * of the blocks that moved or changed shape are recomputed, found through a
+ * block-to-net index in compressed sparse row form. The last update is journalled
+ * so a rejected move restores the boxes it changed.
+ */
+class Netlist
+{
+private:
+    struct Box
+    {
+        int left, right, bottom, top;
+    };
+
+    int numBlocks = 0;
+    vector<string> netNames;
+    // pins of net n: netPins[netStart[n] .. netStart[n + 1])
+    vector<int> netStart, netPins;
+    // nets of block b: blockNets[blockStart[b] .. blockStart[b + 1])
+    vector<int> blockStart, blockNets;
+
+    // doubled pin positions the boxes are computed for
+    vector<int> pinXs, pinYs;
+    vector<Box> boxes;
+    // doubled total over all nets
+    long long total = 0;
+
+    // the last update: moved blocks and changed nets with their previous values
+    struct MovedBlock
+    {
+        int block, x, y;
+    };
+    vector<MovedBlock> movedBlocks;
+    vector<pair<int, Box>> changedNets;
+    long long previousTotal = 0;
+
+    vector<int> netStamps;
+    int stamp = 0;
+
+    Box findBox(int net, const vector<int> &xs, const vector<int> &ys) const
+    {
+        Box box = {INT_MAX, INT_MIN, INT_MAX, INT_MIN};
+        for (int p = netStart[net]; p < netStart[net + 1]; p++)
+        {
+            int b = netPins[p];
+            box.left = min(box.left, xs[b]);
+            box.right = max(box.right, xs[b]);
+            box.bottom = min(box.bottom, ys[b]);
+            box.top = max(box.top, ys[b]);
+        }
+        return box;
+    }
+
+    static inline long long halfPerimeter(const Box &box)
+    {
+        return static_cast<long long>(box.right - box.left) + (box.top - box.bottom);
+    }
+
+public:
+    Netlist() {}
+
+    // nets as lists of block indices; nets of fewer than two blocks carry no wirelength and are dropped
+    Netlist(int numBlocks, const vector<vector<int>> &nets, const vector<string> &names) : numBlocks(numBlocks)
+    {
+        netStart.push_back(0);
+        blockStart.assign(numBlocks + 1, 0);
+        for (size_t n = 0; n < nets.size(); n++)
+        {
+            vector<int> pins = nets[n];
+            sort(pins.begin(), pins.end());
+            pins.erase(unique(pins.begin(), pins.end()), pins.end());
+            if (pins.size() < 2)
+            {
+                continue;
+            }
+            netNames.push_back(names[n]);
+            netPins.insert(netPins.end(), pins.begin(), pins.end());
+            netStart.push_back(static_cast<int>(netPins.size()));
+            for (int b : pins)
+            {
+                blockStart[b + 1]++;
+            }
+        }
+        for (int b = 0; b < numBlocks; b++)
+        {
+            blockStart[b + 1] += blockStart[b];
+        }
+        blockNets.resize(netPins.size());
+        vector<int> next(blockStart.begin(), blockStart.end() - 1);
+        for (int n = 0; n < size(); n++)
+        {
+            for (int p = netStart[n]; p < netStart[n + 1]; p++)
+            {
+                blockNets[next[netPins[p]]++] = n;
+            }
+        }
+
+        // every pin at the origin to begin with, so the boxes match the pins
+        pinXs.assign(numBlocks, 0);
+        pinYs.assign(numBlocks, 0);
+        boxes.assign(size(), Box{0, 0, 0, 0});
+        netStamps.assign(size(), 0);
+    }
+
+    inline int size() const
+    {
+        return static_cast<int>(netNames.size());
+    }
+
+    inline bool empty() const
+    {
+        return netNames.empty();
+    }
+
+    // the same blocks and the same pins on every net
+    inline bool sameNets(const Netlist &other) const
+    {
+        return numBlocks == other.numBlocks && netStart == other.netStart && netPins == other.netPins;
+    }
+
+    inline int getNumPins() const
+    {
+        return static_cast<int>(netPins.size());
+    }
+
+    // wirelength of the pins of the last update
+    inline double getWirelength() const
+    {
+        return total / 2.0;
+    }
+
+    // wirelength of the given doubled pin positions, recomputing the nets of the moved blocks, and journal the change
+    double update(const vector<int> &xs, const vector<int> &ys)
+    {
+        movedBlocks.clear();
+        changedNets.clear();
+        previousTotal = total;
+        if (++stamp == INT_MAX)
+        {
+            fill(netStamps.begin(), netStamps.end(), 0);
+            stamp = 1;
+        }
+        for (int b = 0; b < numBlocks; b++)
+        {
+            if (xs[b] == pinXs[b] && ys[b] == pinYs[b])
+            {
+                continue;
+            }
+            movedBlocks.push_back({b, pinXs[b], pinYs[b]});
+            pinXs[b] = xs[b];
+            pinYs[b] = ys[b];
+            for (int i = blockStart[b]; i < blockStart[b + 1]; i++)
+            {
+                int n = blockNets[i];
+                if (netStamps[n] != stamp)
+                {
+                    netStamps[n] = stamp;
+                    changedNets.push_back({n, boxes[n]});
+                }
+            }
+        }
+        for (const pair<int, Box> &changed : changedNets)
+        {
+            int n = changed.first;
+            boxes[n] = findBox(n, pinXs, pinYs);
+            total += halfPerimeter(boxes[n]) - halfPerimeter(changed.second);
+        }
+        return getWirelength();
+    }
+
+    // wirelength of the given doubled pin positions without touching the cache, safe to call concurrently
+    double evaluate(const vector<int> &xs, const vector<int> &ys) const
+    {
+        vector<int> nets;
+        for (int b = 0; b < numBlocks; b++)
+        {
+            if (xs[b] != pinXs[b] || ys[b] != pinYs[b])
+            {
+                nets.insert(nets.end(), blockNets.begin() + blockStart[b], blockNets.begin() + blockStart[b + 1]);
+            }
+        }
+        sort(nets.begin(), nets.end());
+        nets.erase(unique(nets.begin(), nets.end()), nets.end());
+        long long sum = total;
+        for (int n : nets)
+        {
+            sum += halfPerimeter(findBox(n, xs, ys)) - halfPerimeter(boxes[n]);
+        }
+        return sum / 2.0;
+    }
+
+    // the boxes of the last update are kept
+    inline void commit()
+    {
+        movedBlocks.clear();
+        changedNets.clear();
+        previousTotal = total;
+    }
+
+    // restore the pins and boxes before the last update
+    void rollback()
+    {
+        for (const MovedBlock &moved : movedBlocks)
+        {
+            pinXs[moved.block] = moved.x;
+            pinYs[moved.block] = moved.y;
+        }
+        for (const pair<int, Box> &changed : changedNets)
+        {
+            boxes[changed.first] = changed.second;
+        }
+        total = previousTotal;
+        commit();
+    }
+};
+
+#endif // NETLIST_HPP
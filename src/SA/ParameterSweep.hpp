@@ -0,0 +1,314 @@
+#ifndef PARAMETERSWEEP_HPP
+#define PARAMETERSWEEP_HPP
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+#include "SimulatedAnnealing.hpp"
+#include "ThreadPool.hpp"
+#include "CpuTopology.hpp"
+#include "../api.h"
+
+using namespace std;
+
+/*
+ * Searches the annealing schedule and the moves factor k of a design around the
+ * given parameters: each value spans a factor of 10 on temperatures, 2 on the
+ * cooling distance 1 - coolingRate, and 2 on targetIterations and k. Configurations
+ * anneal side by side on the threads, each on its own scheduler. Successive halving
+ * starts every configuration on a short budget and doubles the budget of the better
+ * half until one runs its full schedule.
+ */
+class ParameterSweep
+{
+public:
+    struct Configuration
+    {
+        double temperature;
+        double coolingRate;
+        double absoluteTemperature;
+        int targetIterations;
+        int k;
+
+        // outcome of the last budget the configuration ran
+        double cost = numeric_limits<double>::infinity();
+        double seconds = 0;
+        int budget = 0;
+        int fullIterations = 0;
+    };
+
+private:
+    // iterations of the whole schedule, as SA::run would count them
+    static int getFullIterations(const Configuration &c)
+    {
+        if (c.targetIterations > 0)
+        {
+            return c.targetIterations;
+        }
+        return max(1, static_cast<int>(log2(c.absoluteTemperature / c.temperature) / log2(c.coolingRate)));
+    }
+
+    static Configuration getBase(const API::Parameters &parm)
+    {
+        Configuration base;
+        base.temperature = parm.temperature;
+        base.coolingRate = parm.coolingRate;
+        base.absoluteTemperature = parm.absoluteTemperature;
+        base.targetIterations = parm.targetIterations;
+        base.k = max(1, parm.movesFactor);
+        return base;
+    }
+
+    static vector<Configuration> getGrid(const API::Parameters &parm)
+    {
+        Configuration base = getBase(parm);
+        double scales[] = {0.1, 1, 10};
+        double distances[] = {2, 1, 0.5};
+        double lengths[] = {0.5, 1, 2};
+        int numLengths = base.targetIterations > 0 ? 3 : 1;
+        vector<Configuration> grid;
+        for (double t : scales)
+        {
+            for (double d : distances)
+            {
+                for (double a : scales)
+                {
+                    for (int l = 0; l < numLengths; l++)
+                    {
+                        for (double m : lengths)
+                        {
+                            Configuration c = base;
+                            c.temperature = base.temperature * t;
+                            c.coolingRate = min(0.999, 1 - (1 - base.coolingRate) * d);
+                            c.absoluteTemperature = base.absoluteTemperature * a;
+                            c.targetIterations = base.targetIterations > 0 ? max(1, static_cast<int>(base.targetIterations * lengths[l])) : 0;
+                            c.k = max(1, static_cast<int>(base.k * m));
+                            grid.push_back(c);
+                        }
+                    }
+                }
+            }
+        }
+        return grid;
+    }
+
+    // log-uniform over the same ranges as the grid
+    static vector<Configuration> getSamples(const API::Parameters &parm, int count, mt19937 &generator)
+    {
+        Configuration base = getBase(parm);
+        uniform_real_distribution<double> unit(-1, 1);
+        vector<Configuration> samples;
+        for (int i = 0; i < count; i++)
+        {
+            Configuration c = base;
+            c.temperature = base.temperature * pow(10, unit(generator));
+            c.coolingRate = min(0.999, 1 - (1 - base.coolingRate) * pow(2, unit(generator)));
+            c.absoluteTemperature = base.absoluteTemperature * pow(10, unit(generator));
+            c.targetIterations = base.targetIterations > 0 ? max(1, static_cast<int>(base.targetIterations * pow(2, unit(generator)))) : 0;
+            c.k = max(1, static_cast<int>(round(base.k * pow(2, unit(generator)))));
+            samples.push_back(c);
+        }
+        return samples;
+    }
+
+    // anneal the given configurations for budget iterations each, fraction of their schedule when shift > 0
+    template <class SchedulerType>
+    static void runAll(vector<Configuration *> &configurations, int shift, const function<SchedulerType *(int)> &createScheduler,
+                       ThreadPool &pool, const API::Parameters &parm, unique_ptr<SchedulerType> &best, double &bestCost, mutex &bestLock)
+    {
+        pool.parallelFor(static_cast<int>(configurations.size()), 1, [&](int first, int last)
+                         {
+            for (int i = first; i < last && !API::task_cancel; i++)
+            {
+                Configuration &c = *configurations[i];
+                API::Parameters runParm = parm;
+                runParm.temperature = c.temperature;
+                runParm.coolingRate = c.coolingRate;
+                runParm.absoluteTemperature = c.absoluteTemperature;
+                runParm.threads = 1;
+                runParm.targetCost = 0;
+                c.fullIterations = getFullIterations(c);
+                c.budget = max(1, c.fullIterations >> shift);
+                runParm.targetIterations = c.budget;
+
+                auto start = chrono::high_resolution_clock::now();
+                unique_ptr<SchedulerType> scheduler(createScheduler(c.k));
+                ostringstream log;
+                SA::run(*scheduler, log, runParm);
+                c.cost = scheduler->evaluateState();
+                c.seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+
+                lock_guard<mutex> guard(bestLock);
+                if (c.cost < bestCost)
+                {
+                    bestCost = c.cost;
+                    best = move(scheduler);
+                }
+            } });
+    }
+
+public:
+    /*
+     * Run the sweep of parm.sweepMode and log the ranked table. The scheduler with
+     * the best floorplan found is left in best, and the best configuration is saved
+     * to parm.tunedParameters when set.
+     */
+    template <class SchedulerType>
+    static vector<Configuration> run(const function<SchedulerType *(int)> &createScheduler, unique_ptr<SchedulerType> &best, ostream &logFile, const API::Parameters &parm)
+    {
+        mt19937 generator(random_device{}());
+        vector<Configuration> configurations;
+        int samples = max(1, parm.sweepSamples);
+        const char *modes[] = {"none", "grid", "random", "successive halving"};
+        if (parm.sweepMode == API::GRID_SWEEP)
+        {
+            configurations = getGrid(parm);
+        }
+        else
+        {
+            configurations = getSamples(parm, samples, generator);
+        }
+
+        int threads = max(1, parm.threads);
+        CpuTopology topology;
+        ThreadPool pool(threads, parm.pinThreads ? topology.getPlacements(threads) : vector<int>());
+        logFile << "Sweep: " << modes[parm.sweepMode] << ", configurations: " << configurations.size() << ", threads: " << pool.size() << endl;
+
+        double bestCost = numeric_limits<double>::infinity();
+        mutex bestLock;
+        auto start = chrono::high_resolution_clock::now();
+        vector<Configuration *> running;
+        for (Configuration &c : configurations)
+        {
+            running.push_back(&c);
+        }
+
+        if (parm.sweepMode == API::SUCCESSIVE_HALVING)
+        {
+            // rung r runs a 2^(rungs - r) fraction of the schedule, the last one all of it
+            int rungs = 0;
+            while ((2 << rungs) <= static_cast<int>(running.size()))
+            {
+                rungs++;
+            }
+            for (int rung = 0; rung <= rungs && !API::task_cancel; rung++)
+            {
+                runAll(running, rungs - rung, createScheduler, pool, parm, best, bestCost, bestLock);
+                sort(running.begin(), running.end(), [](const Configuration *a, const Configuration *b)
+                     { return a->cost < b->cost; });
+                logFile << "Rung " << rung << ": " << running.size() << " configurations, best " << running.front()->cost << endl;
+                running.resize(max<size_t>(1, running.size() / 2));
+                API::task_progress = (float)(rung + 1) / (rungs + 1);
+            }
+        }
+        else
+        {
+            runAll(running, 0, createScheduler, pool, parm, best, bestCost, bestLock);
+        }
+        double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        if (API::task_cancel)
+        {
+            logFile << "Task cancelled" << endl;
+        }
+
+        // full schedules first, then by cost and time
+        sort(configurations.begin(), configurations.end(), [](const Configuration &a, const Configuration &b)
+             {
+                 bool aFull = a.budget >= a.fullIterations, bFull = b.budget >= b.fullIterations;
+                 if (aFull != bFull)
+                 {
+                     return aFull;
+                 }
+                 if (a.cost != b.cost)
+                 {
+                     return a.cost < b.cost;
+                 }
+                 return a.seconds < b.seconds; });
+
+        logFile << setw(5) << "Rank" << setw(14) << "temperature" << setw(13) << "coolingRate" << setw(21) << "absoluteTemperature"
+                << setw(18) << "targetIterations" << setw(5) << "k" << setw(12) << "Iterations" << setw(14) << "Cost" << setw(12) << "Time" << endl;
+        for (size_t i = 0; i < configurations.size(); i++)
+        {
+            const Configuration &c = configurations[i];
+            logFile << setw(5) << i + 1 << setw(14) << c.temperature << setw(13) << c.coolingRate << setw(21) << c.absoluteTemperature
+                    << setw(18) << c.targetIterations << setw(5) << c.k << setw(12) << (to_string(c.budget) + "/" + to_string(c.fullIterations))
+                    << setw(14) << c.cost << setw(12) << c.seconds << endl;
+        }
+        logFile << "Sweep wall time: " << seconds << "s" << endl;
+
+        if (parm.tunedParameters[0] && !configurations.empty() && configurations.front().budget > 0)
+        {
+            save(parm.tunedParameters, configurations.front());
+            logFile << "Tuned parameters saved to " << parm.tunedParameters << endl;
+        }
+        return configurations;
+    }
+
+    static void save(const string &path, const Configuration &c)
+    {
+        ofstream file(path);
+        if (!file.is_open())
+        {
+            throw runtime_error("Could not write tuned parameters");
+        }
+        file << setprecision(17);
+        file << "temperature " << c.temperature << "\n";
+        file << "coolingRate " << c.coolingRate << "\n";
+        file << "absoluteTemperature " << c.absoluteTemperature << "\n";
+        file << "targetIterations " << c.targetIterations << "\n";
+        file << "movesFactor " << c.k << "\n";
+    }
+
+    // override the schedule of parm with a saved configuration
+    static void load(const string &path, API::Parameters &parm)
+    {
+        ifstream file(path);
+        if (!file.is_open())
+        {
+            throw runtime_error("Could not open tuned parameters");
+        }
+        string key;
+        while (file >> key)
+        {
+            if (key == "temperature")
+            {
+                file >> parm.temperature;
+            }
+            else if (key == "coolingRate")
+            {
+                file >> parm.coolingRate;
+            }
+            else if (key == "absoluteTemperature")
+            {
+                file >> parm.absoluteTemperature;
+            }
+            else if (key == "targetIterations")
+            {
+                file >> parm.targetIterations;
+            }
+            else if (key == "movesFactor")
+            {
+                file >> parm.movesFactor;
+            }
+            else
+            {
+                throw runtime_error("Unknown tuned parameter " + key);
+            }
+        }
+    }
+};
+
+#endif // PARAMETERSWEEP_HPP
@@ -19,15 +19,28 @@ class SequencePairGraph : public Graph<Coordinates<int> *, NoProperty>
 {
 private:
     int numNodes;
+    bool transitiveReduction = false;
+    vector<int> orderX; // vertex at each position of the x sequence
 
-    inline void checkAndAddEdge(int v1, int v2)
+    inline int getX(int v) const
     {
-        int x1 = getVertexProperty(v1).getValue()->getX();
-        int y1 = getVertexProperty(v1).getValue()->getY();
-        int x2 = getVertexProperty(v2).getValue()->getX();
-        int y2 = getVertexProperty(v2).getValue()->getY();
+        return getVertexProperty(v).getValue()->getX();
+    }
+
+    inline int getY(int v) const
+    {
+        return getVertexProperty(v).getValue()->getY();
+    }
 
-        if (x1 < x2 && y1 < y2)
+    // true if u lies in the quadrant after v in both sequences
+    inline bool isAfter(int v, int u) const
+    {
+        return getX(v) < getX(u) && getY(v) < getY(u);
+    }
+
+    inline void checkAndAddEdge(int v1, int v2)
+    {
+        if (isAfter(v1, v2))
         {
             addDirectedEdge(v1, v2, getVertexProperty(v1).getValue()->getValue());
         }
@@ -38,11 +51,18 @@ private:
 
         for (int v1 = 0; v1 < numNodes; v1++)
         {
-            for (int v2 = 0; v2 < numNodes; v2++)
+            if (transitiveReduction)
+            {
+                addImmediateSuccessors(v1);
+            }
+            else
             {
-                if (v1 != v2)
+                for (int v2 = 0; v2 < numNodes; v2++)
                 {
-                    checkAndAddEdge(v1, v2);
+                    if (v1 != v2)
+                    {
+                        checkAndAddEdge(v1, v2);
+                    }
                 }
             }
             // Add edges from source to all nodes
@@ -79,12 +99,127 @@ private:
         addDirectedEdge(v2, numNodes + 1, getVertexProperty(v2).getValue()->getValue());
     }
 
+    /*
+     * Add an edge from v to every vertex that follows v in both sequences with no
+     * other vertex in between. Scanning the x sequence after v, such a vertex is
+     * one whose y position is the lowest seen so far above v.
+     */
+    void addImmediateSuccessors(int v)
+    {
+        int yv = getY(v);
+        int minY = numNodes;
+        float weight = getVertexProperty(v).getValue()->getValue();
+        for (int p = getX(v) + 1; p < numNodes; p++)
+        {
+            int u = orderX[p];
+            int yu = getY(u);
+            if (yu > yv && yu < minY)
+            {
+                addDirectedEdge(v, u, weight);
+                minY = yu;
+            }
+        }
+    }
+
+    // remove the edges from v to other blocks, keeping the edge to the sink
+    void clearSuccessors(int v)
+    {
+        for (int u : getNeighbors(v))
+        {
+            if (u != numNodes + 1)
+            {
+                removeDirectedEdge(v, u);
+            }
+        }
+    }
+
+    /*
+     * Insert u into the immediate successors of v, given u lies after v and was
+     * not an immediate successor before. Successors lying after u lose their edge.
+     */
+    void insertSuccessor(int v, int u)
+    {
+        vector<int> successors = getNeighbors(v);
+        for (int s : successors)
+        {
+            if (s != numNodes + 1 && isAfter(s, u))
+            {
+                return;
+            }
+        }
+        for (int s : successors)
+        {
+            if (s != numNodes + 1 && isAfter(u, s))
+            {
+                removeDirectedEdge(v, s);
+            }
+        }
+        addDirectedEdge(v, u, getVertexProperty(v).getValue()->getValue());
+    }
+
+    /*
+     * Keep the transitively reduced edge set after v1 and v2 exchanged positions.
+     * Only blocks that had v1 or v2 as an immediate successor need a full rescan;
+     * for the others the moved blocks can only enter their successor set.
+     */
+    void maintainReducedEdges(int v1, int v2)
+    {
+        vector<bool> rescan(numNodes, false);
+        for (const auto &edge : getInEdges(v1))
+        {
+            if (edge.first < numNodes)
+            {
+                rescan[edge.first] = true;
+            }
+        }
+        for (const auto &edge : getInEdges(v2))
+        {
+            if (edge.first < numNodes)
+            {
+                rescan[edge.first] = true;
+            }
+        }
+        rescan[v1] = rescan[v2] = true;
+
+        for (int a = 0; a < numNodes; a++)
+        {
+            if (rescan[a])
+            {
+                clearSuccessors(a);
+                addImmediateSuccessors(a);
+                continue;
+            }
+            if (isAfter(a, v1))
+            {
+                insertSuccessor(a, v1);
+            }
+            if (isAfter(a, v2))
+            {
+                insertSuccessor(a, v2);
+            }
+        }
+    }
+
+    inline void refreshEdges(int v1, int v2)
+    {
+        if (transitiveReduction)
+        {
+            maintainReducedEdges(v1, v2);
+        }
+        else
+        {
+            maintainEdges(v1, v2);
+        }
+    }
+
 public:
     SequencePairGraph() : Graph<Coordinates<int> *, NoProperty>(0) {}
-    SequencePairGraph(vector<int> &macroSizes, bool isVertical = false)
-        : Graph<Coordinates<int> *, NoProperty>(macroSizes.size() + 2)
+    SequencePairGraph(vector<int> &macroSizes, bool isVertical = false, bool transitiveReduction = false)
+        : Graph<Coordinates<int> *, NoProperty>(macroSizes.size() + 2), transitiveReduction(transitiveReduction)
     {
         numNodes = static_cast<int>(macroSizes.size());
+        orderX.resize(numNodes);
+        iota(orderX.begin(), orderX.end(), 0);
 
         if (isVertical)
         {
@@ -119,8 +254,9 @@ public:
         int temp = getVertexProperty(v1).getValue()->getX();
         getVertexProperty(v1).getValue()->setX(getVertexProperty(v2).getValue()->getX());
         getVertexProperty(v2).getValue()->setX(temp);
+        swap(orderX[getX(v1)], orderX[getX(v2)]);
 
-        maintainEdges(v1, v2);
+        refreshEdges(v1, v2);
     }
 
     void swapY(int v1, int v2)
@@ -129,7 +265,7 @@ public:
         getVertexProperty(v1).getValue()->setY(getVertexProperty(v2).getValue()->getY());
         getVertexProperty(v2).getValue()->setY(temp);
 
-        maintainEdges(v1, v2);
+        refreshEdges(v1, v2);
     }
 
     /*
@@ -140,12 +276,13 @@ public:
         int temp = getVertexProperty(v1).getValue()->getX();
         getVertexProperty(v1).getValue()->setX(getVertexProperty(v2).getValue()->getX());
         getVertexProperty(v2).getValue()->setX(temp);
+        swap(orderX[getX(v1)], orderX[getX(v2)]);
 
         temp = getVertexProperty(v1).getValue()->getY();
         getVertexProperty(v1).getValue()->setY(getVertexProperty(v2).getValue()->getY());
         getVertexProperty(v2).getValue()->setY(temp);
 
-        maintainEdges(v1, v2);
+        refreshEdges(v1, v2);
     }
 
     void updateEdges(int v1)
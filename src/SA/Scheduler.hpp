@@ -9,16 +9,25 @@
 #include <unordered_map>
 #include <chrono>
 #include <random>
+#include <limits>
+#include <cmath>
 
 #include "Macro.hpp"
+#include "SchedulerBase.hpp"
 #include "SEQPairGraph.hpp"
 #include "Coordinates.hpp"
+#include "CostCache.hpp"
+#include "ThreadPool.hpp"
+#include "CompactSequencePair.hpp"
+#include "Netlist.hpp"
 #include "Algorithms/TopologicalSort.hpp"
 #include "Algorithms/LongestPath.hpp"
 
 using namespace std;
 
 const int NUM_MOVES = 4;
+// probability of picking the first block of a move among the critical blocks
+const float CRITICAL_MOVE_BIAS = 0.8f;
 enum Moves
 {
     M1,
@@ -27,37 +36,179 @@ enum Moves
     M4
 };
 
-class Scheduler
+class Scheduler : public SchedulerBase
 {
-private:
-    chrono::high_resolution_clock::time_point start, end;
+public:
+    // a move drawn without touching the state; for M3, v2 is the new aspect index
+    struct ProposedMove
+    {
+        int move, v1, v2;
+    };
 
+private:
     SequencePairGraph *horizontalGraph, *verticalGraph;
 
-    int numNodes, k;
-    int movesCount = 0;
-    int uphillCount = 0;
-    int rejectCount = 0;
+    Moves previousMove;
+    pair<int, int> previousIndices;
 
-    bool improving = true;
-    bool run = true;
+    long long skippedMoves = 0;
 
-    double temperature = 1;
-    double coolingRate = 0.95;
+    // blocks with more than one shape, the only ones M3 can change
+    vector<int> reshapableBlocks;
 
-    Moves previousMove;
-    pair<int, int> previousIndices;
+    // true if the move would only exchange two interchangeable blocks and relabel the layout; with nets they carry different pins
+    inline bool isSymmetricMove(int move, int v1, int v2) const
+    {
+        if (wirelengthWeight > 0 || !netlist.empty())
+        {
+            return false;
+        }
+        return move == M4 && macroClass[v1] == macroClass[v2] && macroDimensionsIndex[v1] == macroDimensionsIndex[v2];
+    }
+
+    // blocks with zero slack on the axis that sets the cost
+    bool criticalMoves = false;
+    vector<int> criticalBlocks, candidateCriticalBlocks;
+
+    // Zobrist hash over the (shape, position X, position Y) of every block, and the cost cache it keys;
+    // with a wirelength cost blocks of the same shape differ by their pins, so their ids are hashed too
+    uint64_t stateHash = 0;
+    bool hashBlocks = false;
+    CostCache *costCache = nullptr;
+
+    // workers of the level-synchronous longest path, null for the serial pass
+    ThreadPool *threadPool = nullptr;
+    LongestPath<Coordinates<int> *, NoProperty>::LevelCache levelsH, levelsV;
+
+    // proposals evaluated ahead from the current state and their costs
+    int speculativeMoves = 0;
+    vector<ProposedMove> proposedMoves;
+    vector<double> proposedCosts;
+
+    // nets of the design, their wirelength weighted into the cost when the weight is positive
+    Netlist netlist;
+    double wirelengthWeight = 0;
+    vector<int> pinXs, pinYs;
+
+    // the best state accepted while tracking, with the cost of the last evaluation it is judged by
+    bool trackBest = false;
+    double lastCost = numeric_limits<double>::infinity();
+    double trackedCost = numeric_limits<double>::infinity();
+    CompactSequencePair trackedState;
+    vector<int> trackedShapes;
+
+    // fixed outline of the die, 0 when the cost is max(width, height)
+    int dieWidth = 0, dieHeight = 0;
+    double outlinePenalty = 0;
+    // the next evaluation may stop once its cost exceeds the limit
+    double costLimit = numeric_limits<double>::infinity();
+    long long boundedEvaluations = 0, earlyStops = 0;
+    // whether the last floorplan evaluated fits the die, and when the first kept one did
+    bool candidateFits = false;
+    vector<char> proposedFits;
+    double firstFeasible = -1;
+    chrono::high_resolution_clock::time_point outlineStart;
+
+    inline bool fits(float width, float height) const
+    {
+        return width <= dieWidth && height <= dieHeight;
+    }
+
+    // a floorplan of the aspect ratio of the die, every unit beyond its outline paid at the penalty
+    inline double shapeCost(float width, float height) const
+    {
+        if (!hasOutline())
+        {
+            return max(width, height);
+        }
+        return max(static_cast<double>(width), static_cast<double>(height) * dieWidth / dieHeight) +
+               outlinePenalty * (max(0.0f, width - dieWidth) + max(0.0f, height - dieHeight));
+    }
+
+    inline void keepCandidate()
+    {
+        if (hasOutline() && candidateFits && firstFeasible < 0)
+        {
+            firstFeasible = chrono::duration<double>(chrono::high_resolution_clock::now() - outlineStart).count();
+        }
+    }
+
+    inline bool hasWirelengthCost() const
+    {
+        return wirelengthWeight > 0 && !netlist.empty();
+    }
+
+    // wirelength of the blocks at the given positions, journalled for a reject
+    double updateWirelength(const vector<float> &xStarts, const vector<float> &yStarts)
+    {
+        for (int i = 0; i < numNodes; i++)
+        {
+            pinXs[i] = 2 * static_cast<int>(xStarts[i]) + getWidth(i);
+            pinYs[i] = 2 * static_cast<int>(yStarts[i]) + getHeight(i);
+        }
+        return netlist.update(pinXs, pinYs);
+    }
+
+    inline int getPositionX(int v) const
+    {
+        return horizontalGraph->getVertexProperty(v).getValue()->getX();
+    }
+
+    inline int getPositionY(int v) const
+    {
+        return horizontalGraph->getVertexProperty(v).getValue()->getY();
+    }
+
+    inline uint64_t getShape(int v) const
+    {
+        return Zobrist::shape(macroDimensions[v][macroDimensionsIndex[v]].first, macroDimensions[v][macroDimensionsIndex[v]].second);
+    }
+
+    inline uint64_t getKey(int v) const
+    {
+        return Zobrist::key(hashBlocks ? getShape(v) ^ Zobrist::block(v) : getShape(v), getPositionX(v), getPositionY(v));
+    }
+
+    void rehash()
+    {
+        stateHash = 0;
+        for (int i = 0; i < numNodes; i++)
+        {
+            stateHash ^= getKey(i);
+        }
+    }
 
-    vector<Macro> macros;
-    float minAspectRatio, maxAspectRatio;
-    vector<vector<pair<int, int>>> macroDimensions;
-    vector<int> macroDimensionsIndex;
+    // collect the zero slack blocks of the axis (or both axes on a tie) that sets the cost
+    void findCriticalBlocks(const vector<float> &slacksH, const vector<float> &slacksV, float width, float height)
+    {
+        candidateCriticalBlocks.clear();
+        for (int i = 0; i < numNodes; i++)
+        {
+            bool criticalH = width >= height && slacksH[i] < 0.5f;
+            bool criticalV = height >= width && slacksV[i] < 0.5f;
+            if (criticalH || criticalV)
+            {
+                candidateCriticalBlocks.push_back(i);
+            }
+        }
+    }
+
+    inline int getRandomBlock()
+    {
+        if (criticalMoves && !criticalBlocks.empty() && getRandomNumber(0.0f, 1.0f) < CRITICAL_MOVE_BIAS)
+        {
+            return criticalBlocks[getRandomNumber(0, static_cast<int>(criticalBlocks.size()) - 1)];
+        }
+        return getRandomNumber(0, numNodes - 1);
+    }
 
     // move 1: swapX
     inline void move1(int v1, int v2)
     {
+        stateHash ^= getKey(v1) ^ getKey(v2);
         horizontalGraph->swapX(v1, v2);
         verticalGraph->swapY(v1, v2);
+        stateHash ^= getKey(v1) ^ getKey(v2);
         previousMove = M1;
         previousIndices = {v1, v2};
     }
@@ -65,8 +216,10 @@ private:
     // move 2: swapY
     inline void move2(int v1, int v2)
     {
+        stateHash ^= getKey(v1) ^ getKey(v2);
         horizontalGraph->swapY(v1, v2);
         verticalGraph->swapX(v1, v2);
+        stateHash ^= getKey(v1) ^ getKey(v2);
         previousMove = M2;
         previousIndices = {v1, v2};
     }
@@ -75,6 +228,7 @@ private:
     inline void move3(int v, int aspectIndex = -1)
     {
         int originalIndex = macroDimensionsIndex[v];
+        stateHash ^= getKey(v);
         if (aspectIndex == -1)
         {
             aspectIndex = (originalIndex + 1) % macroDimensions[v].size();
@@ -84,6 +238,7 @@ private:
         {
             macroDimensionsIndex[v] = aspectIndex;
         }
+        stateHash ^= getKey(v);
         int w = macroDimensions[v][aspectIndex].first;
         int h = macroDimensions[v][aspectIndex].second;
         horizontalGraph->getVertexProperty(v).getValue()->setValue(w);
@@ -97,258 +252,552 @@ private:
     // move 4: swap both
     inline void move4(int v1, int v2)
     {
+        stateHash ^= getKey(v1) ^ getKey(v2);
         horizontalGraph->swapBoth(v1, v2);
         verticalGraph->swapBoth(v1, v2);
+        stateHash ^= getKey(v1) ^ getKey(v2);
         previousMove = M4;
         previousIndices = {v1, v2};
     }
 
-    vector<pair<int, int>> findIntegerDimensions(int area, float minAspectRatio, float maxAspectRatio)
+    ProposedMove pickMove()
     {
-        vector<pair<int, int>> combinations;
-
-        // width <= height
-        for (int width = 1; width * width <= area; ++width)
+        int v1 = getRandomBlock();
+        int v2 = getRandomNumber(0, numNodes - 1);
+        if (v1 == v2)
         {
-            if (area % width == 0)
-            {
-                int height = area / width;
-                int minHeight = static_cast<int>(width * minAspectRatio);
-                int maxHeight = static_cast<int>(width * maxAspectRatio);
-
-                // Check if height is within the valid range
-                if (minHeight <= height && height <= maxHeight)
-                {
-                    combinations.push_back(make_pair(width, height));
-                }
-            }
+            v2 = (v1 + 1) % numNodes;
         }
-        // width > height, simply swap width and height
-        int size = static_cast<int>(combinations.size());
-        for (int i = 0; i < size; ++i)
+        int move = getRandomNumber(0, NUM_MOVES - 1);
+        while (move == M3 && macroDimensions[v1].size() == 1)
         {
-            if (combinations[i].first != combinations[i].second)
-            {
-                combinations.push_back(make_pair(combinations[i].second, combinations[i].first));
-            }
+            move = getRandomNumber(0, NUM_MOVES - 1);
         }
+        // swapping both sequences of two identical blocks only relabels the layout
+        if (isSymmetricMove(move, v1, v2))
+        {
+            skippedMoves++;
+            move = getRandomNumber(M1, M2);
+        }
+        if (move == M3)
+        {
+            int v = criticalMoves ? v1 : reshapableBlocks[getRandomNumber(0, static_cast<int>(reshapableBlocks.size()) - 1)];
+            return {M3, v, static_cast<int>((macroDimensionsIndex[v] + 1) % macroDimensions[v].size())};
+        }
+        return {move, v1, v2};
+    }
+
+    void applyMove(const ProposedMove &proposedMove)
+    {
+        switch (proposedMove.move)
+        {
+        case M1:
+            move1(proposedMove.v1, proposedMove.v2);
+            break;
+        case M2:
+            move2(proposedMove.v1, proposedMove.v2);
+            break;
+        case M3:
+            move3(proposedMove.v1, proposedMove.v2);
+            break;
+        case M4:
+            move4(proposedMove.v1, proposedMove.v2);
+            break;
 
-        return combinations;
+        default:
+            cerr << "Invalid move" << endl;
+            break;
+        }
     }
 
-public:
-    Scheduler(vector<Macro> &macros, float minAspectRatio, float maxAspectRatio, int k = 7, int timeLimit = 10) : k(k), macros(macros), minAspectRatio(minAspectRatio), maxAspectRatio(maxAspectRatio)
+    void applyMove(CompactSequencePair &state, const ProposedMove &proposedMove) const
     {
-        start = chrono::high_resolution_clock::now();
-        end = start + chrono::minutes(timeLimit);
+        switch (proposedMove.move)
+        {
+        case M1:
+            state.swapX(proposedMove.v1, proposedMove.v2);
+            break;
+        case M2:
+            state.swapY(proposedMove.v1, proposedMove.v2);
+            break;
+        case M3:
+            state.setShape(proposedMove.v1, macroDimensions[proposedMove.v1][proposedMove.v2].first, macroDimensions[proposedMove.v1][proposedMove.v2].second);
+            break;
+        case M4:
+            state.swapBoth(proposedMove.v1, proposedMove.v2);
+            break;
 
-        numNodes = macros.size();
-        macroDimensions.resize(numNodes);
-        macroDimensionsIndex.resize(numNodes, 0);
+        default:
+            break;
+        }
+    }
 
+public:
+    Scheduler(vector<Macro> &macros, float minAspectRatio, float maxAspectRatio, int k = 7, int timeLimit = 10, bool transitiveReduction = false)
+        : SchedulerBase(macros, minAspectRatio, maxAspectRatio, k, timeLimit)
+    {
         vector<int> macroWidths, macroHeights;
         for (int i = 0; i < numNodes; i++)
         {
-            int area = macros[i].getWidth() * macros[i].getHeight();
-            macroDimensions[i] = findIntegerDimensions(area, minAspectRatio, maxAspectRatio);
-            if (macroDimensions[i].empty())
+            macroWidths.push_back(getWidth(i));
+            macroHeights.push_back(getHeight(i));
+            if (macroDimensions[i].size() > 1)
             {
-                cerr << "No valid dimensions found for macro " << macros[i].getName() << endl;
-                exit(1);
+                reshapableBlocks.push_back(i);
             }
-            int idx = getRandomNumber(0, macroDimensions[i].size() - 1);
-            macroWidths.push_back(macroDimensions[i][idx].first);
-            macroHeights.push_back(macroDimensions[i][idx].second);
-            macroDimensionsIndex[i] = idx;
         }
 
-        horizontalGraph = new SequencePairGraph(macroWidths);
-        verticalGraph = new SequencePairGraph(macroHeights, true);
+        horizontalGraph = new SequencePairGraph(macroWidths, false, transitiveReduction);
+        verticalGraph = new SequencePairGraph(macroHeights, true, transitiveReduction);
+
+        rehash();
     }
 
     ~Scheduler()
     {
         delete horizontalGraph;
         delete verticalGraph;
+        delete costCache;
+        delete threadPool;
+    }
+
+    // capacity of 0 disables the cost cache
+    inline void setCostCache(int capacity)
+    {
+        if (capacity <= 0)
+        {
+            delete costCache;
+            costCache = nullptr;
+            return;
+        }
+        if (!costCache || costCache->capacity() < static_cast<size_t>(capacity))
+        {
+            delete costCache;
+            costCache = new CostCache(capacity);
+        }
+        costCache->resetCounters();
     }
 
-    inline void initialize()
+    // threads of a single evaluation, 1 keeps it serial
+    inline void setThreads(int threads)
     {
-        run = true;
-        movesCount = 0;
-        rejectCount = 0;
-        uphillCount = 0;
+        if (threadPool && threadPool->size() == threads)
+        {
+            return;
+        }
+        delete threadPool;
+        threadPool = threads > 1 ? new ThreadPool(threads) : nullptr;
     }
 
-    inline void setTemperature(double temperature)
+    inline uint64_t getCacheHits() const
     {
-        this->temperature = temperature;
+        return costCache ? costCache->getHits() : 0;
     }
 
-    inline void setCoolingRate(double coolingRate)
+    inline uint64_t getCacheLookups() const
     {
-        this->coolingRate = coolingRate;
+        return costCache ? costCache->getLookups() : 0;
     }
 
-    // event handlers
-    inline void makeRandomModification()
+    inline long long getSkippedMoves() const
+    {
+        return skippedMoves;
+    }
+
+    inline uint64_t getStateHash() const
+    {
+        return stateHash;
+    }
+
+    // weight of the average net wirelength in the cost, 0 leaves the cost max(width, height)
+    void setNetlist(const Netlist &netlist, double wirelengthWeight)
     {
-        movesCount++;
-        if (movesCount > 2 * numNodes * k)
+        // the cached costs of a kept scheduler were computed with the previous nets
+        if (costCache && (wirelengthWeight != this->wirelengthWeight || !netlist.sameNets(this->netlist)))
         {
-            run = false;
+            costCache->clear();
         }
-        int v1 = getRandomNumber(0, numNodes - 1);
-        int v2 = getRandomNumber(0, numNodes - 1);
-        if (v1 == v2)
+        this->netlist = netlist;
+        this->wirelengthWeight = wirelengthWeight;
+        pinXs.resize(numNodes);
+        pinYs.resize(numNodes);
+        if (hashBlocks != hasWirelengthCost())
         {
-            v2 = (v1 + 1) % numNodes;
+            hashBlocks = hasWirelengthCost();
+            rehash();
         }
-        // make a random modification to the current graph (state)
-        int move = getRandomNumber(0, NUM_MOVES - 1);
-        while (move == M3 && macroDimensions[v1].size() == 1)
+    }
+
+    // fit the floorplan in a die of the given size, 0 leaves the cost max(width, height)
+    void setOutline(int dieWidth, int dieHeight, double outlinePenalty)
+    {
+        // the cached costs of a kept scheduler were computed for the previous outline
+        if (costCache && (dieWidth != this->dieWidth || dieHeight != this->dieHeight || outlinePenalty != this->outlinePenalty))
         {
-            move = getRandomNumber(0, NUM_MOVES - 1);
+            costCache->clear();
         }
-        switch (move)
-        {
-        case M1:
-            move1(v1, v2);
-            break;
-        case M2:
-            move2(v1, v2);
-            break;
-        case M3:
-            move3(getRandomNumber(0, numNodes - 1));
-            break;
-        case M4:
-            move4(v1, v2);
-            break;
+        this->dieWidth = dieWidth;
+        this->dieHeight = dieHeight;
+        this->outlinePenalty = outlinePenalty;
+        firstFeasible = -1;
+        boundedEvaluations = 0;
+        earlyStops = 0;
+        outlineStart = chrono::high_resolution_clock::now();
+    }
 
-        default:
-            cerr << "Invalid move" << endl;
-            break;
-        }
+    inline bool hasOutline() const
+    {
+        return dieWidth > 0 && dieHeight > 0;
     }
 
-    inline double evaluateState()
+    // the wirelength or the outline take part in the cost
+    inline bool hasCompositeCost() const
     {
-        pair<vector<float>, vector<int>> longestPathH = LongestPath<Coordinates<int> *, NoProperty>::findLongestPath(*horizontalGraph);
-        pair<vector<float>, vector<int>> longestPathV = LongestPath<Coordinates<int> *, NoProperty>::findLongestPath(*verticalGraph);
+        return hasWirelengthCost() || hasOutline();
+    }
 
-        vector<float> costsH = longestPathH.first;
-        vector<float> costsV = longestPathV.first;
+    // seconds from setOutline to the first floorplan kept inside the die, negative if none
+    inline double getFirstFeasible() const
+    {
+        return firstFeasible;
+    }
 
-        return max(costsH.back(), costsV.back());
+    inline long long getBoundedEvaluations() const
+    {
+        return boundedEvaluations;
     }
 
-    inline void accept() {}
+    inline long long getEarlyStops() const
+    {
+        return earlyStops;
+    }
 
-    inline void uphill()
+    // keep a copy of every state accepted as a new best, for an island to post
+    void setBestTracking(bool trackBest)
     {
-        uphillCount++;
-        if (uphillCount > numNodes)
-        {
-            run = false;
-        }
+        this->trackBest = trackBest;
+        trackedCost = numeric_limits<double>::infinity();
     }
 
-    inline void reject()
+    inline double getTrackedCost() const
     {
-        rejectCount++;
+        return trackedCost;
+    }
 
-        switch (previousMove)
+    inline const CompactSequencePair &getTrackedState() const
+    {
+        return trackedState;
+    }
+
+    inline const vector<int> &getTrackedShapes() const
+    {
+        return trackedShapes;
+    }
+
+    inline void setCostLimit(double costLimit)
+    {
+        this->costLimit = costLimit;
+    }
+
+    // width and height of the current floorplan
+    pair<float, float> getSize()
+    {
+        vector<float> costsH = LongestPath<Coordinates<int> *, NoProperty>::find(*horizontalGraph);
+        vector<float> costsV = LongestPath<Coordinates<int> *, NoProperty>::find(*verticalGraph);
+        return make_pair(costsH.back(), costsV.back());
+    }
+
+    inline bool hasNets() const
+    {
+        return !netlist.empty();
+    }
+
+    // half-perimeter wirelength of the current floorplan
+    double getWirelength()
+    {
+        vector<float> costsH = LongestPath<Coordinates<int> *, NoProperty>::findLongestPath(*horizontalGraph).first;
+        vector<float> costsV = LongestPath<Coordinates<int> *, NoProperty>::findLongestPath(*verticalGraph).first;
+        double wirelength = updateWirelength(costsH, costsV);
+        netlist.commit();
+        return wirelength;
+    }
+
+    inline void setCriticalMoves(bool criticalMoves)
+    {
+        this->criticalMoves = criticalMoves;
+        criticalBlocks.clear();
+    }
+
+    // the sequences and shapes of the current state
+    CompactSequencePair getCompactState() const
+    {
+        CompactSequencePair state(numNodes);
+        for (int i = 0; i < numNodes; i++)
         {
-        case M1:
-            move1(previousIndices.first, previousIndices.second);
-            break;
-        case M2:
-            move2(previousIndices.first, previousIndices.second);
-            break;
-        case M3:
-            move3(previousIndices.first, previousIndices.second);
-            break;
-        case M4:
-            move4(previousIndices.first, previousIndices.second);
-            break;
+            state.posX[i] = getPositionX(i);
+            state.posY[i] = getPositionY(i);
+            state.setShape(i, getWidth(i), getHeight(i));
+        }
+        state.updateSequences();
+        return state;
+    }
 
-        default:
-            break;
+    // move to the given sequences and shapes through swaps, keeping the graphs and the hash in step
+    void loadCompactState(const CompactSequencePair &state, const vector<int> &shapeIndices)
+    {
+        CompactSequencePair current = getCompactState();
+        for (int p = 0; p < numNodes; p++)
+        {
+            int b = state.seqX[p], c = current.seqX[p];
+            if (b != c)
+            {
+                move1(b, c);
+                current.swapX(b, c);
+            }
+            b = state.seqY[p], c = current.seqY[p];
+            if (b != c)
+            {
+                move2(b, c);
+                current.swapY(b, c);
+            }
+        }
+        for (int i = 0; i < numNodes; i++)
+        {
+            if (macroDimensionsIndex[i] != shapeIndices[i])
+            {
+                move3(i, shapeIndices[i]);
+            }
         }
+        criticalBlocks.clear();
     }
 
-    // scheduling functions
-    inline bool isImproving()
+    // proposals need a critical set refreshed by every evaluation, so critical moves stay serial
+    inline void setSpeculativeMoves(int speculativeMoves)
     {
-        temperature *= coolingRate;
-        // check if the current state is improving
-        if (rejectCount / movesCount > 0.99)
+        this->speculativeMoves = speculativeMoves;
+    }
+
+    inline int getSpeculativeMoves() const
+    {
+        return criticalMoves || numNodes < 2 ? 0 : speculativeMoves;
+    }
+
+    // draw the proposals from the current state and evaluate them on private copies
+    int proposeMoves()
+    {
+        CompactSequencePair state = getCompactState();
+        proposedMoves.resize(speculativeMoves);
+        proposedCosts.resize(speculativeMoves);
+        proposedFits.resize(speculativeMoves);
+        for (int i = 0; i < speculativeMoves; i++)
         {
-            improving = false;
+            proposedMoves[i] = pickMove();
         }
-        return improving;
+        auto evaluate = [&](int begin, int end)
+        {
+            vector<int> xs(numNodes), ys(numNodes);
+            for (int i = begin; i < end; i++)
+            {
+                CompactSequencePair candidate = state;
+                applyMove(candidate, proposedMoves[i]);
+                int width = candidate.findWidth(&xs);
+                int height = candidate.findHeight(&ys);
+                proposedFits[i] = fits(width, height);
+                proposedCosts[i] = shapeCost(width, height);
+                if (!hasWirelengthCost())
+                {
+                    continue;
+                }
+                // the cached net boxes are only read, so the proposals may be scored concurrently
+                for (int b = 0; b < numNodes; b++)
+                {
+                    xs[b] = 2 * xs[b] + candidate.widths[b];
+                    ys[b] = 2 * ys[b] + candidate.heights[b];
+                }
+                proposedCosts[i] += wirelengthWeight * netlist.evaluate(xs, ys) / netlist.size();
+            }
+        };
+        if (threadPool)
+        {
+            threadPool->parallelFor(speculativeMoves, 1, evaluate);
+        }
+        else
+        {
+            evaluate(0, speculativeMoves);
+        }
+        return speculativeMoves;
     }
 
-    inline bool canContinue()
+    inline double getProposedCost(int i) const
     {
-        return run;
+        return proposedCosts[i];
     }
 
-    inline bool hasTimeExpired()
+    inline void applyProposedMove(int i)
     {
-        // check if there is still time left
-        return chrono::high_resolution_clock::now() >= end;
+        countMove();
+        candidateFits = proposedFits[i];
+        lastCost = proposedCosts[i];
+        applyMove(proposedMoves[i]);
     }
 
-    // in seconds
-    inline int getElapsed()
+    // event handlers
+    inline void makeRandomModification()
     {
-        return chrono::duration_cast<chrono::seconds>(chrono::high_resolution_clock::now() - start).count();
+        countMove();
+        // make a random modification to the current graph (state)
+        applyMove(pickMove());
     }
 
-    inline double getTemperature()
+    inline double evaluateState()
     {
-        return temperature;
+        // without a limit the state is kept whatever its cost
+        double limit = costLimit;
+        costLimit = numeric_limits<double>::infinity();
+        double cost;
+        bool cachedFits;
+        if (costCache && costCache->find(stateHash, cost, cachedFits))
+        {
+            // the critical set is only refreshed by computed evaluations
+            candidateCriticalBlocks = criticalBlocks;
+            candidateFits = cachedFits;
+            lastCost = cost;
+            if (std::isinf(limit))
+            {
+                keepCandidate();
+            }
+            return cost;
+        }
+        cost = computeCost(limit);
+        lastCost = cost;
+        if (std::isinf(limit))
+        {
+            keepCandidate();
+        }
+        if (costCache && !std::isinf(cost))
+        {
+            costCache->insert(stateHash, cost, candidateFits);
+        }
+        return cost;
     }
 
-    inline int getStepPerIteration()
+    // the cost of the current state, infinite once it is known to exceed the limit
+    inline double computeCost(double limit = numeric_limits<double>::infinity())
     {
-        return 2 * numNodes * k;
+        if (criticalMoves)
+        {
+            pair<vector<float>, vector<float>> slackH = LongestPath<Coordinates<int> *, NoProperty>::findSlack(*horizontalGraph);
+            pair<vector<float>, vector<float>> slackV = LongestPath<Coordinates<int> *, NoProperty>::findSlack(*verticalGraph);
+            float width = slackH.first.back();
+            float height = slackV.first.back();
+            findCriticalBlocks(slackH.second, slackV.second, width, height);
+            candidateFits = fits(width, height);
+            return shapeCost(width, height) + wirelengthCost(slackH.first, slackV.first);
+        }
+
+        if (threadPool)
+        {
+            vector<float> costsH = LongestPath<Coordinates<int> *, NoProperty>::findParallel(*horizontalGraph, *threadPool, levelsH);
+            vector<float> costsV = LongestPath<Coordinates<int> *, NoProperty>::findParallel(*verticalGraph, *threadPool, levelsV);
+            candidateFits = fits(costsH.back(), costsV.back());
+            return shapeCost(costsH.back(), costsV.back()) + wirelengthCost(costsH, costsV);
+        }
+
+        if (!std::isinf(limit))
+        {
+            // every distance bounds its axis from below, and the wirelength is never negative
+            boundedEvaluations++;
+            vector<float> costsH, costsV;
+            if (!LongestPath<Coordinates<int> *, NoProperty>::findBounded(*horizontalGraph, costsH, [&](float width)
+                                                                          { return shapeCost(width, 0) > limit; }))
+            {
+                earlyStops++;
+                return numeric_limits<double>::infinity();
+            }
+            float width = costsH.back();
+            if (!LongestPath<Coordinates<int> *, NoProperty>::findBounded(*verticalGraph, costsV, [&](float height)
+                                                                          { return shapeCost(width, height) > limit; }))
+            {
+                earlyStops++;
+                return numeric_limits<double>::infinity();
+            }
+            candidateFits = fits(width, costsV.back());
+            return shapeCost(width, costsV.back()) + wirelengthCost(costsH, costsV);
+        }
+
+        pair<vector<float>, vector<int>> longestPathH = LongestPath<Coordinates<int> *, NoProperty>::findLongestPath(*horizontalGraph);
+        pair<vector<float>, vector<int>> longestPathV = LongestPath<Coordinates<int> *, NoProperty>::findLongestPath(*verticalGraph);
+
+        vector<float> costsH = longestPathH.first;
+        vector<float> costsV = longestPathV.first;
+
+        candidateFits = fits(costsH.back(), costsV.back());
+        return shapeCost(costsH.back(), costsV.back()) + wirelengthCost(costsH, costsV);
     }
 
-    // random generator, range: [min, max]
-    inline int getRandomNumber(int min, int max)
+    // the wirelength term of the cost, the blocks at the given longest path distances
+    inline double wirelengthCost(const vector<float> &costsH, const vector<float> &costsV)
     {
-        static random_device rd;
-        static mt19937 gen(rd());
-        uniform_int_distribution<int> dis(min, max);
-        return dis(gen);
+        if (!hasWirelengthCost())
+        {
+            return 0;
+        }
+        return wirelengthWeight * updateWirelength(costsH, costsV) / netlist.size();
     }
 
-    inline float getRandomNumber(float min, float max)
+    inline void accept()
     {
-        static random_device rd;
-        static mt19937 gen(rd());
-        uniform_real_distribution<float> dis(min, max);
-        return dis(gen);
+        criticalBlocks.swap(candidateCriticalBlocks);
+        netlist.commit();
+        keepCandidate();
+        if (trackBest && lastCost < trackedCost)
+        {
+            trackedCost = lastCost;
+            trackedState = getCompactState();
+            trackedShapes = macroDimensionsIndex;
+        }
     }
 
-    void saveFloorplan(string filename)
+    inline void uphill()
     {
-        ofstream fout(filename);
-        if (!fout.is_open())
+        criticalBlocks.swap(candidateCriticalBlocks);
+        netlist.commit();
+        keepCandidate();
+        SchedulerBase::uphill();
+    }
+
+    inline void reject()
+    {
+        rejectCount++;
+        netlist.rollback();
+
+        switch (previousMove)
         {
-            throw runtime_error("Could not open file");
+        case M1:
+            move1(previousIndices.first, previousIndices.second);
+            break;
+        case M2:
+            move2(previousIndices.first, previousIndices.second);
+            break;
+        case M3:
+            move3(previousIndices.first, previousIndices.second);
+            break;
+        case M4:
+            move4(previousIndices.first, previousIndices.second);
+            break;
+
+        default:
+            break;
         }
-        
+    }
 
+    void saveFloorplan(string filename)
+    {
         vector<int> topologicalOrderH = Topological<Coordinates<int> *, NoProperty>::sort(*horizontalGraph);
         vector<int> topologicalOrderV = Topological<Coordinates<int> *, NoProperty>::sort(*verticalGraph);
         vector<float> costsH = LongestPath<Coordinates<int> *, NoProperty>::find(*horizontalGraph, topologicalOrderH);
         vector<float> costsV = LongestPath<Coordinates<int> *, NoProperty>::find(*verticalGraph, topologicalOrderV);
 
-        fout << "reset\nset title \"result\"\nset xlabel \"X\"\nset ylabel \"Y\"\n";
-
         vector<int> xStarts(numNodes), yStarts(numNodes);
         for (int i = 1; i <= numNodes; i++)
         {
@@ -356,24 +805,7 @@ public:
             yStarts[topologicalOrderV[i]] = costsV[topologicalOrderV[i]];
         }
 
-        int counter = 1;
-
-        for (int i = 0; i < numNodes; i++)
-        {
-            int x = xStarts[i];
-            int y = yStarts[i];
-            int w = horizontalGraph->getVertexProperty(i).getValue()->getValue();
-            int h = verticalGraph->getVertexProperty(i).getValue()->getValue();
-            string name = macros[i].getName();
-            fout << "set object " << counter++ << " rect from " << x << "," << y << " to " << x + w << "," << y + h << "\n";
-            fout << "set label \"" << name << "\" at " << x + w / 2 << "," << y + h / 2 << " center\n";
-        }
-        fout << "set xtics " + to_string(costsH.back() / 5) + "\n";
-        fout << "set ytics " + to_string(costsV.back() / 5) + "\n";
-        fout << "plot [0:" + to_string(costsH.back()) + "][0:" + to_string(costsV.back()) + "]0\n";
-        fout << "set terminal png size 1024,768\nset output \"./output/output.png\"\nreplot\n";
-
-        fout.close();
+        writeFloorplan(filename, xStarts, yStarts, costsH.back(), costsV.back());
     }
 };
 
@@ -0,0 +1,359 @@
+#ifndef SCHEDULERBASE_HPP
+#define SCHEDULERBASE_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <random>
+#include <map>
+#include <stdexcept>
+#include <cstdint>
+
+#include "Macro.hpp"
+
+using namespace std;
+
+/*
+ * Bookkeeping shared by the floorplan representations driven by SA::run: the
+ * cooling schedule, the move budget of an iteration, the legal shapes of every
+ * macro and the gnuplot output. A representation derives from it and provides
+ * makeRandomModification, evaluateState, reject and saveFloorplan.
+ */
+class SchedulerBase
+{
+protected:
+    chrono::high_resolution_clock::time_point start, end;
+
+    int numNodes, k;
+    int movesCount = 0;
+    int uphillCount = 0;
+    int rejectCount = 0;
+
+    bool improving = true;
+    bool run = true;
+
+    double temperature = 1;
+    double coolingRate = 0.95;
+
+    vector<Macro> macros;
+    float minAspectRatio, maxAspectRatio;
+    vector<vector<pair<int, int>>> macroDimensions;
+    vector<int> macroDimensionsIndex;
+
+    // every scheduler draws from its own generator, so chains can run on separate threads
+    mt19937 generator;
+
+    // macros with identical dimension options share an equivalence class
+    vector<int> macroClass;
+
+    void findMacroClasses()
+    {
+        map<vector<pair<int, int>>, int> classes;
+        macroClass.resize(numNodes);
+        for (int i = 0; i < numNodes; i++)
+        {
+            auto it = classes.insert(make_pair(macroDimensions[i], static_cast<int>(classes.size()))).first;
+            macroClass[i] = it->second;
+        }
+    }
+
+    vector<pair<int, int>> findIntegerDimensions(int area, float minAspectRatio, float maxAspectRatio)
+    {
+        vector<pair<int, int>> combinations;
+
+        // width <= height
+        for (int width = 1; width * width <= area; ++width)
+        {
+            if (area % width == 0)
+            {
+                int height = area / width;
+                int minHeight = static_cast<int>(width * minAspectRatio);
+                int maxHeight = static_cast<int>(width * maxAspectRatio);
+
+                // Check if height is within the valid range
+                if (minHeight <= height && height <= maxHeight)
+                {
+                    combinations.push_back(make_pair(width, height));
+                }
+            }
+        }
+        // width > height, simply swap width and height
+        int size = static_cast<int>(combinations.size());
+        for (int i = 0; i < size; ++i)
+        {
+            if (combinations[i].first != combinations[i].second)
+            {
+                combinations.push_back(make_pair(combinations[i].second, combinations[i].first));
+            }
+        }
+
+        return combinations;
+    }
+
+    // count a move against the budget of the current iteration
+    inline void countMove()
+    {
+        movesCount++;
+        if (movesCount > 2 * numNodes * k)
+        {
+            run = false;
+        }
+    }
+
+    inline int getWidth(int v) const
+    {
+        return macroDimensions[v][macroDimensionsIndex[v]].first;
+    }
+
+    inline int getHeight(int v) const
+    {
+        return macroDimensions[v][macroDimensionsIndex[v]].second;
+    }
+
+    // write the placed blocks as a gnuplot script
+    void writeFloorplan(string filename, const vector<int> &xStarts, const vector<int> &yStarts, float width, float height)
+    {
+        ofstream fout(filename);
+        if (!fout.is_open())
+        {
+            throw runtime_error("Could not open file");
+        }
+
+        fout << "reset\nset title \"result\"\nset xlabel \"X\"\nset ylabel \"Y\"\n";
+
+        int counter = 1;
+
+        for (int i = 0; i < numNodes; i++)
+        {
+            int x = xStarts[i];
+            int y = yStarts[i];
+            int w = getWidth(i);
+            int h = getHeight(i);
+            string name = macros[i].getName();
+            fout << "set object " << counter++ << " rect from " << x << "," << y << " to " << x + w << "," << y + h << "\n";
+            fout << "set label \"" << name << "\" at " << x + w / 2 << "," << y + h / 2 << " center\n";
+        }
+        fout << "set xtics " + to_string(width / 5) + "\n";
+        fout << "set ytics " + to_string(height / 5) + "\n";
+        fout << "plot [0:" + to_string(width) + "][0:" + to_string(height) + "]0\n";
+        fout << "set terminal png size 1024,768\nset output \"./output/output.png\"\nreplot\n";
+
+        fout.close();
+    }
+
+public:
+    SchedulerBase(vector<Macro> &macros, float minAspectRatio, float maxAspectRatio, int k = 7, int timeLimit = 10) : k(k), macros(macros), minAspectRatio(minAspectRatio), maxAspectRatio(maxAspectRatio), generator(random_device()())
+    {
+        start = chrono::high_resolution_clock::now();
+        end = start + chrono::minutes(timeLimit);
+
+        numNodes = macros.size();
+        macroDimensions.resize(numNodes);
+        macroDimensionsIndex.resize(numNodes, 0);
+
+        for (int i = 0; i < numNodes; i++)
+        {
+            int area = macros[i].getWidth() * macros[i].getHeight();
+            macroDimensions[i] = findIntegerDimensions(area, minAspectRatio, maxAspectRatio);
+            if (macroDimensions[i].empty())
+            {
+                cerr << "No valid dimensions found for macro " << macros[i].getName() << endl;
+                exit(1);
+            }
+            macroDimensionsIndex[i] = getRandomNumber(0, macroDimensions[i].size() - 1);
+        }
+        findMacroClasses();
+    }
+
+    // blocks with given shape options, such as the composite blocks of a coarsened design
+    SchedulerBase(const vector<vector<pair<int, int>>> &dimensions, int k = 7, int timeLimit = 10) : k(k), minAspectRatio(0), maxAspectRatio(0), macroDimensions(dimensions), generator(random_device()())
+    {
+        start = chrono::high_resolution_clock::now();
+        end = start + chrono::minutes(timeLimit);
+
+        numNodes = dimensions.size();
+        macroDimensionsIndex.resize(numNodes, 0);
+        for (int i = 0; i < numNodes; i++)
+        {
+            macros.push_back(Macro("node_" + to_string(i), dimensions[i][0].first, dimensions[i][0].second));
+        }
+        findMacroClasses();
+    }
+
+    inline void initialize()
+    {
+        run = true;
+        movesCount = 0;
+        rejectCount = 0;
+        uphillCount = 0;
+    }
+
+    inline void setTemperature(double temperature)
+    {
+        this->temperature = temperature;
+    }
+
+    inline void setCoolingRate(double coolingRate)
+    {
+        this->coolingRate = coolingRate;
+    }
+
+    // options of the sequence pair representation, ignored by the others
+    inline void setCriticalMoves(bool) {}
+
+    inline void setCostCache(int) {}
+
+    inline void setThreads(int) {}
+
+    // costs above the limit are rejected, so the next evaluation may stop once it exceeds it; sequence pair only
+    inline void setCostLimit(double) {}
+
+    // whether the cost is more than max(width, height); sequence pair only
+    inline bool hasCompositeCost() const
+    {
+        return false;
+    }
+
+    // speculative evaluation of several proposals from the same state, sequence pair only
+    inline void setSpeculativeMoves(int) {}
+
+    inline int getSpeculativeMoves() const
+    {
+        return 0;
+    }
+
+    inline int proposeMoves()
+    {
+        return 0;
+    }
+
+    inline double getProposedCost(int) const
+    {
+        return 0;
+    }
+
+    inline void applyProposedMove(int) {}
+
+    // a rejected proposal still counts against the move budget
+    inline void skipProposedMove()
+    {
+        countMove();
+        rejectCount++;
+    }
+
+    // moves a rejection-free step stands for without drawing them, counted as rejected
+    inline void skipMoves(double count)
+    {
+        int budget = 2 * numNodes * k + 1 - movesCount;
+        int skipped = count < budget ? static_cast<int>(count) : max(0, budget);
+        movesCount += skipped;
+        rejectCount += skipped;
+        if (movesCount > 2 * numNodes * k)
+        {
+            run = false;
+        }
+    }
+
+    inline uint64_t getCacheHits() const
+    {
+        return 0;
+    }
+
+    inline uint64_t getCacheLookups() const
+    {
+        return 0;
+    }
+
+    inline long long getSkippedMoves() const
+    {
+        return 0;
+    }
+
+    // width and height options of every block
+    inline const vector<vector<pair<int, int>>> &getMacroDimensions() const
+    {
+        return macroDimensions;
+    }
+
+    inline const vector<int> &getShapeIndices() const
+    {
+        return macroDimensionsIndex;
+    }
+
+    inline int getNumNodes() const
+    {
+        return numNodes;
+    }
+
+    inline void setSeed(unsigned seed)
+    {
+        generator.seed(seed);
+    }
+
+    inline void accept() {}
+
+    inline void uphill()
+    {
+        uphillCount++;
+        if (uphillCount > numNodes)
+        {
+            run = false;
+        }
+    }
+
+    // scheduling functions
+    inline bool isImproving()
+    {
+        temperature *= coolingRate;
+        // check if the current state is improving
+        if (rejectCount / movesCount > 0.99)
+        {
+            improving = false;
+        }
+        return improving;
+    }
+
+    inline bool canContinue()
+    {
+        return run;
+    }
+
+    inline bool hasTimeExpired()
+    {
+        // check if there is still time left
+        return chrono::high_resolution_clock::now() >= end;
+    }
+
+    // in seconds
+    inline int getElapsed()
+    {
+        return chrono::duration_cast<chrono::seconds>(chrono::high_resolution_clock::now() - start).count();
+    }
+
+    inline double getTemperature()
+    {
+        return temperature;
+    }
+
+    inline int getStepPerIteration()
+    {
+        return 2 * numNodes * k;
+    }
+
+    // random generator, range: [min, max]
+    inline int getRandomNumber(int min, int max)
+    {
+        uniform_int_distribution<int> dis(min, max);
+        return dis(generator);
+    }
+
+    inline float getRandomNumber(float min, float max)
+    {
+        uniform_real_distribution<float> dis(min, max);
+        return dis(generator);
+    }
+};
+
+#endif // SCHEDULERBASE_HPP
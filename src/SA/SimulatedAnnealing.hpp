@@ -7,6 +7,8 @@
 #include <chrono>
 #include <string>
 #include <vector>
+#include <functional>
+#include <cmath>
 
 #include "Scheduler.hpp"
 #include "../api.h"
@@ -15,8 +17,105 @@ using namespace std;
 
 class SA
 {
+private:
+    enum Decision
+    {
+        ACCEPT,
+        UPHILL,
+        REJECT
+    };
+
+    // Metropolis criterion against the current cost with the uniform draw, improvements on the best cost always pass
+    template <class SchedulerType>
+    static Decision decide(SchedulerType &scheduler, double newCost, double &bestCost, double &currentCost, double draw)
+    {
+        if (newCost <= bestCost)
+        {
+            bestCost = newCost;
+            currentCost = newCost;
+            return ACCEPT;
+        }
+        double acceptanceProbability = exp((currentCost - newCost) / scheduler.getTemperature());
+        if (acceptanceProbability > draw)
+        {
+            currentCost = newCost;
+            return UPHILL;
+        }
+        return REJECT;
+    }
+
+    static void countStep(int &steps, int &targetSteps, double bestCost, const API::Parameters &parm, ostream &logFile, chrono::high_resolution_clock::time_point start)
+    {
+        steps++;
+
+        if (targetSteps == 0 && parm.targetCost > 0 && bestCost <= parm.targetCost)
+        {
+            targetSteps = steps;
+            logFile << "Target cost " << parm.targetCost << " reached after " << steps << " moves, "
+                    << chrono::duration<double>(chrono::high_resolution_clock::now() - start).count() << "s" << endl;
+        }
+    }
+
+    /*
+     * N-fold way step: every proposal is scored, one is drawn in proportion to its
+     * acceptance probability and applied. The moves a plain walk would have rejected
+     * before reaching an acceptance, the proposals over the summed probabilities on
+     * average, advance the move budget as simulated time. The proposals are only a
+     * sample of the neighbourhood, so a step never stands for more moves than it
+     * scored: below a summed probability of 1 the drawn move is applied with that
+     * probability, as one of the scored proposals would have been.
+     */
+    template <class SchedulerType>
+    static double rejectionFreeStep(SchedulerType &scheduler, double &bestCost, double &currentCost, int &steps, int &targetSteps,
+                                    const API::Parameters &parm, ostream &logFile, chrono::high_resolution_clock::time_point start)
+    {
+        int count = scheduler.proposeMoves();
+        vector<double> weights(count);
+        double total = 0;
+        for (int i = 0; i < count; i++)
+        {
+            double newCost = scheduler.getProposedCost(i);
+            weights[i] = newCost <= currentCost ? 1 : exp((currentCost - newCost) / scheduler.getTemperature());
+            total += weights[i];
+            countStep(steps, targetSteps, bestCost, parm, logFile, start);
+        }
+        if (total < 1 && scheduler.getRandomNumber(0.0f, 1.0f) >= total)
+        {
+            scheduler.skipMoves(count);
+            return count;
+        }
+
+        double pick = scheduler.getRandomNumber(0.0f, 1.0f) * total;
+        int chosen = 0;
+        while (chosen < count - 1 && pick >= weights[chosen])
+        {
+            pick -= weights[chosen];
+            chosen++;
+        }
+        double simulated = count / max(1.0, total);
+        scheduler.skipMoves(simulated - 1);
+        scheduler.applyProposedMove(chosen);
+        double newCost = scheduler.getProposedCost(chosen);
+        currentCost = newCost;
+        if (newCost <= bestCost)
+        {
+            bestCost = newCost;
+            scheduler.accept();
+        }
+        else
+        {
+            scheduler.uphill();
+        }
+        return simulated;
+    }
+
 public:
-    static void run(Scheduler &scheduler, ofstream &logFile, const API::Parameters &parm)
+    /*
+     * migrate is called every parm.migrationInterval iterations with the current cost,
+     * and may replace the state with a better one and lower the cost accordingly.
+     */
+    template <class SchedulerType>
+    static void run(SchedulerType &scheduler, ostream &logFile, const API::Parameters &parm, const function<void(double &)> &migrate = function<void(double &)>())
     {
         double temperature = parm.temperature;
         double coolingRate = parm.coolingRate;
@@ -27,6 +126,25 @@ public:
 
         scheduler.setTemperature(temperature);
         scheduler.setCoolingRate(coolingRate);
+        scheduler.setCriticalMoves(parm.criticalMoves);
+        logFile << "criticalMoves: " << (parm.criticalMoves ? "on" : "off") << endl;
+        scheduler.setCostCache(parm.costCacheSize);
+        logFile << "costCacheSize: " << parm.costCacheSize << endl;
+        scheduler.setThreads(parm.threads);
+        logFile << "threads: " << parm.threads << endl;
+        scheduler.setSpeculativeMoves(parm.speculativeMoves);
+        int speculativeMoves = scheduler.getSpeculativeMoves();
+        logFile << "speculativeMoves: " << speculativeMoves << endl;
+        // the rejection-free mode draws its neighbourhood through the speculative proposals
+        bool rejectionFreeSupported = false;
+        if (parm.rejectionFreeThreshold > 0)
+        {
+            scheduler.setSpeculativeMoves(max(2, parm.rejectionFreeMoves));
+            rejectionFreeSupported = scheduler.getSpeculativeMoves() > 1;
+            scheduler.setSpeculativeMoves(parm.speculativeMoves);
+            logFile << "rejectionFreeThreshold: " << parm.rejectionFreeThreshold << ", rejectionFreeMoves: " << max(2, parm.rejectionFreeMoves)
+                    << (rejectionFreeSupported ? "" : ", not supported by this representation") << endl;
+        }
         int targetIterations = parm.targetIterations > 0 ? parm.targetIterations : log2(absoluteTemperature / temperature) / log2(coolingRate);
         int currentIteration = 0;
         logFile << "targetIterations: " << targetIterations << endl;
@@ -37,41 +155,94 @@ public:
         logFile << setw(10) << "Time" << setw(10) << "Steps" << setw(20) << "Cost" << endl;
 
         int steps = 0;
+        int targetSteps = 0;
+        long long skippedMoves = scheduler.getSkippedMoves();
+        auto start = chrono::high_resolution_clock::now();
+        bool rejectionFree = false;
+        double simulatedMoves = 0;
 
         do
         {
             scheduler.initialize();
+            int iterationSteps = steps, acceptedSteps = 0;
             while (scheduler.canContinue())
             {
+                if (rejectionFree)
+                {
+                    simulatedMoves += rejectionFreeStep(scheduler, bestCost, currentCost, steps, targetSteps, parm, logFile, start);
+                    continue;
+                }
+                if (speculativeMoves > 1)
+                {
+                    // rejected proposals leave the state as it was, so the next one is still valid
+                    int count = scheduler.proposeMoves();
+                    for (int i = 0; i < count && scheduler.canContinue(); i++)
+                    {
+                        Decision decision = decide(scheduler, scheduler.getProposedCost(i), bestCost, currentCost, scheduler.getRandomNumber(0.0f, 1.0f));
+                        countStep(steps, targetSteps, bestCost, parm, logFile, start);
+                        if (decision == REJECT)
+                        {
+                            scheduler.skipProposedMove();
+                            continue;
+                        }
+                        scheduler.applyProposedMove(i);
+                        acceptedSteps++;
+                        if (decision == ACCEPT)
+                        {
+                            scheduler.accept();
+                        }
+                        else
+                        {
+                            scheduler.uphill();
+                        }
+                        break;
+                    }
+                    continue;
+                }
+
                 // make a random modification to the current tree (state)
                 scheduler.makeRandomModification();
 
+                // drawn ahead, so any cost above currentCost - T ln(draw) is known to be rejected
+                double draw = scheduler.getRandomNumber(0.0f, 1.0f);
+                scheduler.setCostLimit(currentCost - scheduler.getTemperature() * log(draw));
                 double newCost = scheduler.evaluateState();
 
-                if (newCost <= bestCost)
+                switch (decide(scheduler, newCost, bestCost, currentCost, draw))
                 {
-                    bestCost = newCost;
-                    currentCost = newCost;
+                case ACCEPT:
                     scheduler.accept();
-                }
-                else
-                {
-                    double acceptanceProbability = exp((currentCost - newCost) / scheduler.getTemperature());
-                    if (acceptanceProbability > scheduler.getRandomNumber(0.0f, 1.0f))
-                    {
-                        currentCost = newCost;
-                        scheduler.uphill();
-                    }
-                    else
-                    {
-                        scheduler.reject();
-                    }
+                    acceptedSteps++;
+                    break;
+                case UPHILL:
+                    scheduler.uphill();
+                    acceptedSteps++;
+                    break;
+                default:
+                    scheduler.reject();
+                    break;
                 }
 
-                steps++;
+                countStep(steps, targetSteps, bestCost, parm, logFile, start);
             }
             currentIteration++;
 
+            // the acceptance ratio of the iteration decides the switch, once and for good
+            if (!rejectionFree && rejectionFreeSupported && steps > iterationSteps &&
+                (double)acceptedSteps / (steps - iterationSteps) < parm.rejectionFreeThreshold)
+            {
+                scheduler.setSpeculativeMoves(max(2, parm.rejectionFreeMoves));
+                rejectionFree = true;
+                logFile << "Rejection-free from iteration " << currentIteration << ", acceptance ratio "
+                        << (double)acceptedSteps / (steps - iterationSteps) << ", temperature " << scheduler.getTemperature() << endl;
+            }
+
+            if (migrate && parm.migrationInterval > 0 && currentIteration % parm.migrationInterval == 0)
+            {
+                migrate(currentCost);
+                bestCost = min(bestCost, currentCost);
+            }
+
             logFile << setw(10) << scheduler.getElapsed() << setw(10) << steps << setw(20) << bestCost << endl;
 
             API::task_progress = (float)currentIteration / targetIterations;
@@ -100,6 +271,25 @@ public:
         {
             logFile << "Temperature too low, temperature: " << scheduler.getTemperature() << endl;
         }
+        if (parm.targetCost > 0 && targetSteps == 0)
+        {
+            logFile << "Target cost " << parm.targetCost << " not reached after " << steps << " moves" << endl;
+        }
+        double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        if (seconds > 0)
+        {
+            logFile << "Moves per second: " << steps / seconds << endl;
+        }
+        if (rejectionFree)
+        {
+            logFile << "Simulated moves: " << simulatedMoves << endl;
+        }
+        logFile << "Skipped symmetric moves: " << scheduler.getSkippedMoves() - skippedMoves << endl;
+        if (scheduler.getCacheLookups() > 0)
+        {
+            logFile << "Cost cache hits: " << scheduler.getCacheHits() << "/" << scheduler.getCacheLookups()
+                    << " (" << 100.0 * scheduler.getCacheHits() / scheduler.getCacheLookups() << "%)" << endl;
+        }
         logFile << "Result: " << currentCost << endl;
     }
 };
@@ -0,0 +1,227 @@
+#ifndef SKYLINESEEDER_HPP
+#define SKYLINESEEDER_HPP
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// the packer is compiled once, in api.cpp
+#include "imstb_rectpack.h"
+
+#include "CompactSequencePair.hpp"
+
+using namespace std;
+
+// strip widths tried for the skyline packing, as multiples of the side of the total area
+const double SEED_STRIP_WIDTHS[] = {1.0, 1.05, 1.1, 1.2, 1.35, 1.5};
+
+/*
+ * Initial floorplan from the skyline packer of stb_rect_pack: the blocks are packed
+ * into strips of a few widths around the side of the total area, with square, tall
+ * or wide shapes and the bottom-left and best-fit heuristics. The packings are
+ * compared by their extent, and only the best one is turned into a sequence pair,
+ * the conversion being quadratic. Every pair of blocks is separated horizontally or
+ * vertically; a pair separated both ways is free in one of the sequences, so each
+ * sequence is a topological order of the relations forced on it, and the sequence
+ * pair packs no larger than the skyline packing.
+ */
+class SkylineSeeder
+{
+private:
+    enum ShapePolicy
+    {
+        SQUARE,
+        TALL,
+        WIDE,
+        NUM_POLICIES
+    };
+
+    const vector<vector<pair<int, int>>> &dimensions;
+    int numNodes;
+
+    int pickShape(int b, ShapePolicy policy) const
+    {
+        int chosen = 0;
+        for (size_t s = 1; s < dimensions[b].size(); s++)
+        {
+            const pair<int, int> &shape = dimensions[b][s], &best = dimensions[b][chosen];
+            bool better = false;
+            switch (policy)
+            {
+            case TALL:
+                better = shape.first < best.first;
+                break;
+            case WIDE:
+                better = shape.first > best.first;
+                break;
+            default:
+                better = abs(shape.first - shape.second) < abs(best.first - best.second);
+                break;
+            }
+            if (better)
+            {
+                chosen = static_cast<int>(s);
+            }
+        }
+        return chosen;
+    }
+
+    // skyline packing into a strip of the given width, false if a block is wider; extent is max(width, height) of the packing
+    bool pack(const vector<int> &shapes, int stripWidth, int heuristic, vector<int> &xs, vector<int> &ys, long long &extent) const
+    {
+        vector<stbrp_rect> rects(numNodes);
+        long long stripHeight = 0;
+        for (int b = 0; b < numNodes; b++)
+        {
+            rects[b].id = b;
+            rects[b].w = dimensions[b][shapes[b]].first;
+            rects[b].h = dimensions[b][shapes[b]].second;
+            stripHeight += rects[b].h;
+            if (rects[b].w > stripWidth)
+            {
+                return false;
+            }
+        }
+        stbrp_context context;
+        vector<stbrp_node> nodes(stripWidth);
+        stbrp_init_target(&context, stripWidth, static_cast<int>(min<long long>(stripHeight, numeric_limits<int>::max() / 2)), nodes.data(), stripWidth);
+        stbrp_setup_heuristic(&context, heuristic);
+        if (!stbrp_pack_rects(&context, rects.data(), numNodes))
+        {
+            return false;
+        }
+        xs.resize(numNodes);
+        ys.resize(numNodes);
+        extent = 0;
+        for (const stbrp_rect &rect : rects)
+        {
+            xs[rect.id] = rect.x;
+            ys[rect.id] = rect.y;
+            extent = max(extent, static_cast<long long>(max(rect.x + rect.w, rect.y + rect.h)));
+        }
+        return true;
+    }
+
+    // topological order of the blocks under precedes(a, b), smallest x + y first among the ready ones
+    template <class Precedes>
+    void order(const vector<int> &xs, const vector<int> &ys, const Precedes &precedes, vector<int> &pos) const
+    {
+        vector<int> incoming(numNodes, 0);
+        for (int a = 0; a < numNodes; a++)
+        {
+            for (int b = 0; b < numNodes; b++)
+            {
+                if (a != b && precedes(a, b))
+                {
+                    incoming[b]++;
+                }
+            }
+        }
+        vector<bool> placed(numNodes, false);
+        for (int p = 0; p < numNodes; p++)
+        {
+            int next = -1;
+            for (int b = 0; b < numNodes; b++)
+            {
+                if (!placed[b] && incoming[b] == 0 && (next < 0 || xs[b] + ys[b] < xs[next] + ys[next]))
+                {
+                    next = b;
+                }
+            }
+            // cannot happen for a placement without overlaps, break a cycle at the lowest block all the same
+            for (int b = 0; next < 0 && b < numNodes; b++)
+            {
+                if (!placed[b])
+                {
+                    next = b;
+                }
+            }
+            placed[next] = true;
+            pos[next] = p;
+            for (int b = 0; b < numNodes; b++)
+            {
+                if (!placed[b] && precedes(next, b))
+                {
+                    incoming[b]--;
+                }
+            }
+        }
+    }
+
+public:
+    SkylineSeeder(const vector<vector<pair<int, int>>> &dimensions) : dimensions(dimensions), numNodes(dimensions.size())
+    {
+    }
+
+    // the sequence pair of a placement without overlaps
+    void toSequencePair(const vector<int> &xs, const vector<int> &ys, const vector<int> &shapes, CompactSequencePair &state) const
+    {
+        vector<int> right(numNodes), top(numNodes);
+        for (int b = 0; b < numNodes; b++)
+        {
+            state.setShape(b, dimensions[b][shapes[b]].first, dimensions[b][shapes[b]].second);
+            right[b] = xs[b] + state.widths[b];
+            top[b] = ys[b] + state.heights[b];
+        }
+        // a left of b precedes it in both sequences, a below b precedes it in Y and follows it in X
+        auto leftOf = [&](int a, int b)
+        { return right[a] <= xs[b]; };
+        auto below = [&](int a, int b)
+        { return top[a] <= ys[b]; };
+        order(xs, ys, [&](int a, int b)
+              { return (leftOf(a, b) && !below(b, a)) || (below(a, b) && !leftOf(b, a)); },
+              state.posY);
+        order(xs, ys, [&](int a, int b)
+              { return (leftOf(a, b) && !below(a, b)) || (below(b, a) && !leftOf(b, a)); },
+              state.posX);
+        state.updateSequences();
+    }
+
+    // the best skyline packing as a sequence pair and shapes, returns its cost
+    double run(CompactSequencePair &state, vector<int> &shapes) const
+    {
+        double area = 0;
+        for (int b = 0; b < numNodes; b++)
+        {
+            area += static_cast<double>(dimensions[b][0].first) * dimensions[b][0].second;
+        }
+        const int heuristics[] = {STBRP_HEURISTIC_Skyline_BL_sortHeight, STBRP_HEURISTIC_Skyline_BF_sortHeight};
+        long long bestExtent = numeric_limits<long long>::max();
+        state = CompactSequencePair(numNodes);
+        shapes.assign(numNodes, 0);
+
+        vector<int> candidate(numNodes), xs, ys, bestXs, bestYs;
+        for (int policy = 0; policy < NUM_POLICIES; policy++)
+        {
+            for (int b = 0; b < numNodes; b++)
+            {
+                candidate[b] = pickShape(b, static_cast<ShapePolicy>(policy));
+            }
+            for (double factor : SEED_STRIP_WIDTHS)
+            {
+                for (int heuristic : heuristics)
+                {
+                    long long extent;
+                    if (pack(candidate, static_cast<int>(ceil(factor * sqrt(area))), heuristic, xs, ys, extent) && extent < bestExtent)
+                    {
+                        bestExtent = extent;
+                        bestXs.swap(xs);
+                        bestYs.swap(ys);
+                        shapes = candidate;
+                    }
+                }
+            }
+        }
+        if (bestXs.empty())
+        {
+            return numeric_limits<double>::infinity();
+        }
+        // the sequence pair packs no larger than the packing it comes from
+        toSequencePair(bestXs, bestYs, shapes, state);
+        return state.evaluate();
+    }
+};
+
+#endif // SKYLINESEEDER_HPP
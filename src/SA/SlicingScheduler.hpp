@@ -0,0 +1,165 @@
+#ifndef SLICINGSCHEDULER_HPP
+#define SLICINGSCHEDULER_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include "Macro.hpp"
+#include "SchedulerBase.hpp"
+#include "SlicingTree.hpp"
+
+using namespace std;
+
+// tries to find a legal operand/operator swap before falling back to an operand swap
+const int OPERAND_OPERATOR_ATTEMPTS = 8;
+
+enum SlicingMoves
+{
+    SWAP_OPERANDS,
+    INVERT_CHAIN,
+    SWAP_OPERAND_OPERATOR
+};
+
+// Define a scheduler annealing a slicing floorplan; block shapes come from the shape curves
+class SlicingScheduler : public SchedulerBase
+{
+private:
+    SlicingTree tree;
+
+    SlicingMoves previousMove;
+    pair<int, int> previousIndices;
+
+    // positions of the operands, in expression order
+    vector<int> findOperands() const
+    {
+        vector<int> operands;
+        for (int i = 0; i < tree.size(); i++)
+        {
+            if (tree.at(i) >= 0)
+            {
+                operands.push_back(i);
+            }
+        }
+        return operands;
+    }
+
+    // move 1: swap two operands adjacent in operand order
+    inline void swapOperands(int p1, int p2)
+    {
+        tree.swapPositions(p1, p2);
+        previousMove = SWAP_OPERANDS;
+        previousIndices = {p1, p2};
+    }
+
+    // move 2: complement the operator chain around position p
+    inline void invertChain(int first, int last)
+    {
+        tree.invertChain(first, last);
+        previousMove = INVERT_CHAIN;
+        previousIndices = {first, last};
+    }
+
+    // move 3: swap an operand with the operator next to it
+    inline void swapOperandOperator(int p)
+    {
+        tree.swapPositions(p, p + 1);
+        previousMove = SWAP_OPERAND_OPERATOR;
+        previousIndices = {p, p + 1};
+    }
+
+public:
+    SlicingScheduler(vector<Macro> &macros, float minAspectRatio, float maxAspectRatio, int k = 7, int timeLimit = 10)
+        : SchedulerBase(macros, minAspectRatio, maxAspectRatio, k, timeLimit), tree(macroDimensions)
+    {
+    }
+
+    // event handlers
+    inline void makeRandomModification()
+    {
+        countMove();
+        if (numNodes < 2)
+        {
+            return;
+        }
+
+        int move = getRandomNumber(SWAP_OPERANDS, SWAP_OPERAND_OPERATOR);
+        if (move == SWAP_OPERAND_OPERATOR)
+        {
+            for (int attempt = 0; attempt < OPERAND_OPERATOR_ATTEMPTS; attempt++)
+            {
+                int p = getRandomNumber(0, tree.size() - 2);
+                if (tree.canSwapOperandOperator(p))
+                {
+                    swapOperandOperator(p);
+                    return;
+                }
+            }
+            move = SWAP_OPERANDS;
+        }
+
+        if (move == INVERT_CHAIN)
+        {
+            // operators are never first, so walk back from a random operator
+            int p = getRandomNumber(0, tree.size() - 1);
+            while (tree.at(p) >= 0)
+            {
+                p++;
+            }
+            int first = p, last = p;
+            while (tree.at(first - 1) < 0)
+            {
+                first--;
+            }
+            while (last + 1 < tree.size() && tree.at(last + 1) < 0)
+            {
+                last++;
+            }
+            invertChain(first, last);
+            return;
+        }
+
+        vector<int> operands = findOperands();
+        int i = getRandomNumber(0, numNodes - 2);
+        swapOperands(operands[i], operands[i + 1]);
+    }
+
+    inline double evaluateState()
+    {
+        tree.evaluate();
+        const Shape &shape = tree.getRootShape(tree.findBestPoint());
+        return max(shape.width, shape.height);
+    }
+
+    inline void reject()
+    {
+        rejectCount++;
+
+        switch (previousMove)
+        {
+        case SWAP_OPERANDS:
+        case SWAP_OPERAND_OPERATOR:
+            tree.swapPositions(previousIndices.first, previousIndices.second);
+            break;
+        case INVERT_CHAIN:
+            tree.invertChain(previousIndices.first, previousIndices.second);
+            break;
+
+        default:
+            break;
+        }
+        tree.restore();
+    }
+
+    void saveFloorplan(string filename)
+    {
+        tree.evaluate();
+        int point = tree.findBestPoint();
+        vector<int> xs(numNodes), ys(numNodes);
+        tree.place(point, xs, ys, macroDimensionsIndex);
+        const Shape &shape = tree.getRootShape(point);
+        writeFloorplan(filename, xs, ys, shape.width, shape.height);
+    }
+};
+
+#endif // SLICINGSCHEDULER_HPP
@@ -0,0 +1,352 @@
+#ifndef SLICINGTREE_HPP
+#define SLICINGTREE_HPP
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+using namespace std;
+
+// operators of a Polish expression, operands are the block ids
+const int VERTICAL_CUT = -1;   // left and right side by side
+const int HORIZONTAL_CUT = -2; // left below right
+
+// Define a structure for a point of a shape curve
+struct Shape
+{
+    int width;
+    int height;
+    // points of the left and right subtree curves, or the shape index at a leaf
+    int left;
+    int right;
+};
+
+/*
+ * Normalized Polish expression of a slicing floorplan. Every position keeps the
+ * shape curve of the subtree ending there (Stockmeyer). After a move only the
+ * positions whose subtree covers a changed position are recomputed; all other
+ * subtrees are unchanged substrings, so their cached curves stay valid.
+ */
+class SlicingTree
+{
+private:
+    int numNodes;
+    vector<int> expression;
+    vector<vector<Shape>> leafCurves;
+    vector<vector<Shape>> curves;
+
+    // subtree structure of the current expression
+    vector<int> parent, leftChild, stack;
+
+    // positions changed since the last evaluation, and the curves replaced by it
+    vector<int> changed;
+    vector<bool> dirty;
+    vector<pair<int, vector<Shape>>> saved;
+
+    static inline bool isOperator(int token)
+    {
+        return token < 0;
+    }
+
+    // link every operator to its children; the right child is the position before it
+    void findStructure()
+    {
+        stack.clear();
+        for (int i = 0; i < static_cast<int>(expression.size()); i++)
+        {
+            parent[i] = -1;
+            if (isOperator(expression[i]))
+            {
+                int right = stack.back();
+                stack.pop_back();
+                int left = stack.back();
+                stack.pop_back();
+                leftChild[i] = left;
+                parent[left] = parent[right] = i;
+            }
+            stack.push_back(i);
+        }
+    }
+
+    // side by side: widths add, heights take the max
+    static void combineVertical(const vector<Shape> &a, const vector<Shape> &b, vector<Shape> &result)
+    {
+        result.clear();
+        size_t i = 0, j = 0;
+        while (i < a.size() && j < b.size())
+        {
+            int height = max(a[i].height, b[j].height);
+            if (result.empty() || height < result.back().height)
+            {
+                result.push_back({a[i].width + b[j].width, height, static_cast<int>(i), static_cast<int>(j)});
+            }
+            // only lowering the taller side can lower the height
+            if (a[i].height == height)
+            {
+                i++;
+            }
+            if (b[j].height == height)
+            {
+                j++;
+            }
+        }
+    }
+
+    // stacked: heights add, widths take the max
+    static void combineHorizontal(const vector<Shape> &a, const vector<Shape> &b, vector<Shape> &result)
+    {
+        result.clear();
+        int i = static_cast<int>(a.size()) - 1, j = static_cast<int>(b.size()) - 1;
+        while (i >= 0 && j >= 0)
+        {
+            int width = max(a[i].width, b[j].width);
+            if (result.empty() || width < result.back().width)
+            {
+                result.push_back({width, a[i].height + b[j].height, i, j});
+            }
+            // only narrowing the wider side can narrow the width
+            if (a[i].width == width)
+            {
+                i--;
+            }
+            if (b[j].width == width)
+            {
+                j--;
+            }
+        }
+        reverse(result.begin(), result.end());
+    }
+
+    // place the subtree ending at position with the given point of its curve
+    void place(int position, int point, int x, int y, vector<int> &xs, vector<int> &ys, vector<int> &shapeIndex) const
+    {
+        const Shape &shape = curves[position][point];
+        if (!isOperator(expression[position]))
+        {
+            xs[expression[position]] = x;
+            ys[expression[position]] = y;
+            shapeIndex[expression[position]] = shape.left;
+            return;
+        }
+        int left = leftChild[position];
+        int right = position - 1;
+        place(left, shape.left, x, y, xs, ys, shapeIndex);
+        if (expression[position] == VERTICAL_CUT)
+        {
+            place(right, shape.right, x + curves[left][shape.left].width, y, xs, ys, shapeIndex);
+        }
+        else
+        {
+            place(right, shape.right, x, y + curves[left][shape.left].height, xs, ys, shapeIndex);
+        }
+    }
+
+public:
+    SlicingTree() : numNodes(0) {}
+
+    // start from rows of about sqrt(n) blocks stacked on top of each other
+    SlicingTree(const vector<vector<pair<int, int>>> &dimensions) : numNodes(dimensions.size())
+    {
+        int rowLength = max(1, static_cast<int>(sqrt(static_cast<double>(numNodes))));
+        for (int i = 0; i < numNodes; i++)
+        {
+            expression.push_back(i);
+            if (i % rowLength != 0)
+            {
+                expression.push_back(VERTICAL_CUT);
+            }
+            if (i % rowLength == rowLength - 1 || i == numNodes - 1)
+            {
+                if (i >= rowLength)
+                {
+                    expression.push_back(HORIZONTAL_CUT);
+                }
+            }
+        }
+
+        // leaf curves sorted by increasing width, dominated shapes dropped
+        leafCurves.resize(numNodes);
+        for (int b = 0; b < numNodes; b++)
+        {
+            vector<Shape> shapes;
+            for (int s = 0; s < static_cast<int>(dimensions[b].size()); s++)
+            {
+                shapes.push_back({dimensions[b][s].first, dimensions[b][s].second, s, -1});
+            }
+            sort(shapes.begin(), shapes.end(), [](const Shape &a, const Shape &b)
+                 { return a.width < b.width || (a.width == b.width && a.height < b.height); });
+            for (const Shape &shape : shapes)
+            {
+                if (leafCurves[b].empty() || shape.height < leafCurves[b].back().height)
+                {
+                    leafCurves[b].push_back(shape);
+                }
+            }
+        }
+
+        int length = expression.size();
+        curves.resize(length);
+        parent.resize(length);
+        leftChild.resize(length, -1);
+        dirty.resize(length, false);
+        for (int i = 0; i < length; i++)
+        {
+            markChanged(i);
+        }
+    }
+
+    inline int size() const
+    {
+        return expression.size();
+    }
+
+    inline int at(int position) const
+    {
+        return expression[position];
+    }
+
+    inline void markChanged(int position)
+    {
+        changed.push_back(position);
+    }
+
+    // exchange the tokens at two positions
+    inline void swapPositions(int p1, int p2)
+    {
+        swap(expression[p1], expression[p2]);
+        markChanged(p1);
+        markChanged(p2);
+    }
+
+    // complement the operator chain [first, last]
+    inline void invertChain(int first, int last)
+    {
+        for (int i = first; i <= last; i++)
+        {
+            expression[i] = expression[i] == VERTICAL_CUT ? HORIZONTAL_CUT : VERTICAL_CUT;
+            markChanged(i);
+        }
+    }
+
+    /*
+     * true if exchanging the operand and operator at positions p and p + 1 keeps
+     * the expression normalized (no two equal operators in a row) and valid
+     * (every prefix has more operands than operators)
+     */
+    bool canSwapOperandOperator(int p) const
+    {
+        int a = expression[p], b = expression[p + 1];
+        if (isOperator(a) == isOperator(b))
+        {
+            return false;
+        }
+        int op = isOperator(a) ? a : b;
+        // the operator lands at p + 1 or p; compare it to its new neighbours
+        if (isOperator(a))
+        {
+            if (p + 2 < size() && expression[p + 2] == op)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            if (p > 0 && expression[p - 1] == op)
+            {
+                return false;
+            }
+            int operators = 0;
+            for (int i = 0; i < p; i++)
+            {
+                operators += isOperator(expression[i]);
+            }
+            // prefix [0, p] after the swap holds operators + 1 operators among p + 1 tokens
+            if (2 * (operators + 1) >= p + 1)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // recompute the curves of the changed positions and of their ancestors
+    void evaluate()
+    {
+        findStructure();
+        saved.clear();
+
+        vector<int> positions;
+        for (int p : changed)
+        {
+            for (int q = p; q != -1 && !dirty[q]; q = parent[q])
+            {
+                dirty[q] = true;
+                positions.push_back(q);
+            }
+        }
+        changed.clear();
+        // children always sit before their parent
+        sort(positions.begin(), positions.end());
+
+        for (int p : positions)
+        {
+            dirty[p] = false;
+            saved.emplace_back(p, vector<Shape>());
+            saved.back().second.swap(curves[p]);
+            if (!isOperator(expression[p]))
+            {
+                curves[p] = leafCurves[expression[p]];
+            }
+            else if (expression[p] == VERTICAL_CUT)
+            {
+                combineVertical(curves[leftChild[p]], curves[p - 1], curves[p]);
+            }
+            else
+            {
+                combineHorizontal(curves[leftChild[p]], curves[p - 1], curves[p]);
+            }
+        }
+    }
+
+    // put back the curves replaced by the last evaluation
+    void restore()
+    {
+        for (auto &entry : saved)
+        {
+            curves[entry.first].swap(entry.second);
+        }
+        saved.clear();
+        changed.clear();
+    }
+
+    // best point of the root curve for the max(width, height) cost
+    int findBestPoint() const
+    {
+        const vector<Shape> &root = curves.back();
+        int best = 0;
+        for (int i = 1; i < static_cast<int>(root.size()); i++)
+        {
+            if (max(root[i].width, root[i].height) < max(root[best].width, root[best].height))
+            {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    inline const Shape &getRootShape(int point) const
+    {
+        return curves.back()[point];
+    }
+
+    // lower-left corners and chosen shape index of every block for a root point
+    void place(int point, vector<int> &xs, vector<int> &ys, vector<int> &shapeIndex)
+    {
+        findStructure();
+        place(size() - 1, point, 0, 0, xs, ys, shapeIndex);
+    }
+};
+
+#endif // SLICINGTREE_HPP
@@ -0,0 +1,256 @@
+#ifndef SMALLSCHEDULER_HPP
+#define SMALLSCHEDULER_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <array>
+#include <cstdint>
+
+#include "Macro.hpp"
+#include "SchedulerBase.hpp"
+#include "Scheduler.hpp"
+
+using namespace std;
+
+/*
+ * Sequence pair scheduler for designs of at most N <= 64 blocks. The sequences live
+ * in fixed arrays padded with zero-sized blocks at the end of both sequences, so
+ * every loop runs over the compile-time N and the relations of a block are a single
+ * 64-bit mask over the positions of the other sequence.
+ */
+template <int N>
+class SmallScheduler : public SchedulerBase
+{
+    static_assert(N > 0 && N <= 64, "relation masks are 64 bits wide");
+
+private:
+    // block at each position of the two sequences, and the inverse positions
+    array<int, N> seqX, seqY, posX, posY;
+    array<int, N> widths, heights;
+
+    Moves previousMove;
+    pair<int, int> previousIndices;
+
+    uint64_t randomState;
+
+    // xorshift64, far cheaper than a distribution per move
+    inline int getFastRandom(int bound)
+    {
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 7;
+        randomState ^= randomState << 17;
+        return static_cast<int>((randomState >> 32) * static_cast<uint64_t>(bound) >> 32);
+    }
+
+    // positions strictly above p
+    static inline uint64_t above(int p)
+    {
+        return ~uint64_t(0) << p << 1;
+    }
+
+    // positions strictly below p
+    static inline uint64_t below(int p)
+    {
+        return (uint64_t(1) << p) - 1;
+    }
+
+    /*
+     * Blocks left of b come before it in both sequences: walking seqX, the candidates
+     * of b are the visited blocks with a lower Y position. The end of every visited
+     * block is stored at its Y position so the mask indexes it directly.
+     */
+    inline int findWidth(array<int, N> &xs) const
+    {
+        array<int, N> endAt;
+        uint64_t visited = 0;
+        int width = 0;
+        for (int i = 0; i < N; i++)
+        {
+            int b = seqX[i];
+            int p = posY[b];
+            int x = 0;
+            for (uint64_t candidates = visited & below(p); candidates; candidates &= candidates - 1)
+            {
+                x = max(x, endAt[__builtin_ctzll(candidates)]);
+            }
+            xs[b] = x;
+            endAt[p] = x + widths[b];
+            width = max(width, endAt[p]);
+            visited |= uint64_t(1) << p;
+        }
+        return width;
+    }
+
+    // blocks below b come after it in seqX and before it in seqY
+    inline int findHeight(array<int, N> &ys) const
+    {
+        array<int, N> endAt;
+        uint64_t visited = 0;
+        int height = 0;
+        for (int i = 0; i < N; i++)
+        {
+            int b = seqY[i];
+            int p = posX[b];
+            int y = 0;
+            for (uint64_t candidates = visited & above(p); candidates; candidates &= candidates - 1)
+            {
+                y = max(y, endAt[__builtin_ctzll(candidates)]);
+            }
+            ys[b] = y;
+            endAt[p] = y + heights[b];
+            height = max(height, endAt[p]);
+            visited |= uint64_t(1) << p;
+        }
+        return height;
+    }
+
+    inline void swapPositions(array<int, N> &seq, array<int, N> &pos, int v1, int v2)
+    {
+        swap(seq[pos[v1]], seq[pos[v2]]);
+        swap(pos[v1], pos[v2]);
+    }
+
+    // move 1: swapX
+    inline void move1(int v1, int v2)
+    {
+        swapPositions(seqX, posX, v1, v2);
+        previousMove = M1;
+        previousIndices = {v1, v2};
+    }
+
+    // move 2: swapY
+    inline void move2(int v1, int v2)
+    {
+        swapPositions(seqY, posY, v1, v2);
+        previousMove = M2;
+        previousIndices = {v1, v2};
+    }
+
+    // move 3: change dimensions
+    inline void move3(int v, int aspectIndex = -1)
+    {
+        int originalIndex = macroDimensionsIndex[v];
+        if (aspectIndex == -1)
+        {
+            aspectIndex = (originalIndex + 1) % macroDimensions[v].size();
+        }
+        macroDimensionsIndex[v] = aspectIndex;
+        widths[v] = getWidth(v);
+        heights[v] = getHeight(v);
+        previousMove = M3;
+        previousIndices = {v, originalIndex};
+    }
+
+    // move 4: swap both
+    inline void move4(int v1, int v2)
+    {
+        swapPositions(seqX, posX, v1, v2);
+        swapPositions(seqY, posY, v1, v2);
+        previousMove = M4;
+        previousIndices = {v1, v2};
+    }
+
+public:
+    SmallScheduler(vector<Macro> &macros, float minAspectRatio, float maxAspectRatio, int k = 7, int timeLimit = 10)
+        : SchedulerBase(macros, minAspectRatio, maxAspectRatio, k, timeLimit)
+    {
+        if (numNodes > N)
+        {
+            throw runtime_error("Too many macros for the compact scheduler");
+        }
+        // the padding blocks stay behind the real ones in both sequences
+        for (int i = 0; i < N; i++)
+        {
+            seqX[i] = seqY[i] = posX[i] = posY[i] = i;
+            widths[i] = i < numNodes ? getWidth(i) : 0;
+            heights[i] = i < numNodes ? getHeight(i) : 0;
+        }
+        randomState = static_cast<uint64_t>(getRandomNumber(1, 0x7fffffff)) << 16 | 1;
+    }
+
+    // event handlers
+    inline void makeRandomModification()
+    {
+        countMove();
+        if (numNodes == 1)
+        {
+            if (macroDimensions[0].size() > 1)
+            {
+                move3(0);
+            }
+            return;
+        }
+        int v1 = getFastRandom(numNodes);
+        int v2 = getFastRandom(numNodes - 1);
+        if (v2 >= v1)
+        {
+            v2++;
+        }
+        // make a random modification to the current sequences (state)
+        int move = getFastRandom(NUM_MOVES);
+        if (move == M3 && macroDimensions[v1].size() == 1)
+        {
+            move = M4;
+        }
+        switch (move)
+        {
+        case M1:
+            move1(v1, v2);
+            break;
+        case M2:
+            move2(v1, v2);
+            break;
+        case M3:
+            move3(v1);
+            break;
+        case M4:
+            move4(v1, v2);
+            break;
+
+        default:
+            cerr << "Invalid move" << endl;
+            break;
+        }
+    }
+
+    inline double evaluateState()
+    {
+        array<int, N> xs, ys;
+        return max(findWidth(xs), findHeight(ys));
+    }
+
+    inline void reject()
+    {
+        rejectCount++;
+
+        switch (previousMove)
+        {
+        case M1:
+            move1(previousIndices.first, previousIndices.second);
+            break;
+        case M2:
+            move2(previousIndices.first, previousIndices.second);
+            break;
+        case M3:
+            move3(previousIndices.first, previousIndices.second);
+            break;
+        case M4:
+            move4(previousIndices.first, previousIndices.second);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    void saveFloorplan(string filename)
+    {
+        array<int, N> xs, ys;
+        int width = findWidth(xs);
+        int height = findHeight(ys);
+        writeFloorplan(filename, vector<int>(xs.begin(), xs.begin() + numNodes), vector<int>(ys.begin(), ys.begin() + numNodes), width, height);
+    }
+};
+
+#endif // SMALLSCHEDULER_HPP
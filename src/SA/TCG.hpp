@@ -0,0 +1,280 @@
+#ifndef TCG_HPP
+#define TCG_HPP
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "BitMatrix.hpp"
+
+using namespace std;
+
+/*
+ * Transitive closure graph: horizontal[a][b] means a is left of b, vertical[a][b]
+ * means a is below b. Every pair of blocks is related in exactly one of the four
+ * directions and both matrices stay transitively closed, so relation queries are a
+ * single bit test and every state packs without overlaps. An edge change journals
+ * the rows it is about to touch, so undoing it restores those rows only.
+ */
+class TransitiveClosureGraph
+{
+private:
+    int numNodes;
+    int wordsPerRow;
+    BitMatrix horizontal, vertical;
+
+    // rows of the last edge change before it: horizontal or not, row, and its words in savedWords
+    vector<pair<bool, int>> savedRows;
+    vector<uint64_t> savedWords;
+    // a row is saved once per change
+    vector<int> savedStamps[2];
+    int stamp = 0;
+
+    inline BitMatrix &getMatrix(bool isHorizontal)
+    {
+        return isHorizontal ? horizontal : vertical;
+    }
+
+    void beginJournal()
+    {
+        savedRows.clear();
+        savedWords.clear();
+        if (++stamp == numeric_limits<int>::max())
+        {
+            fill(savedStamps[0].begin(), savedStamps[0].end(), 0);
+            fill(savedStamps[1].begin(), savedStamps[1].end(), 0);
+            stamp = 1;
+        }
+    }
+
+    void saveRow(BitMatrix &matrix, int i)
+    {
+        bool isHorizontal = &matrix == &horizontal;
+        int &saved = savedStamps[isHorizontal ? 0 : 1][i];
+        if (saved == stamp)
+        {
+            return;
+        }
+        saved = stamp;
+        savedRows.push_back({isHorizontal, i});
+        const uint64_t *r = matrix.row(i);
+        savedWords.insert(savedWords.end(), r, r + wordsPerRow);
+    }
+
+    inline void setBit(vector<uint64_t> &mask, int i) const
+    {
+        mask[i >> 6] |= uint64_t(1) << (i & 63);
+    }
+
+    // bits of mask collected as node ids
+    vector<int> getNodes(const vector<uint64_t> &mask) const
+    {
+        vector<int> nodes;
+        for (int w = 0; w < wordsPerRow; w++)
+        {
+            uint64_t bits = mask[w];
+            while (bits)
+            {
+                int b = __builtin_ctzll(bits);
+                nodes.push_back(w * 64 + b);
+                bits &= bits - 1;
+            }
+        }
+        return nodes;
+    }
+
+    /*
+     * Relate every node of fanIn to every node of fanOut in closure and drop the
+     * pair from other, both ways. One OR per fanIn row, one AND-NOT per row.
+     */
+    void relate(BitMatrix &closure, BitMatrix &other, const vector<uint64_t> &fanIn, const vector<uint64_t> &fanOut)
+    {
+        vector<int> ins = getNodes(fanIn);
+        vector<int> outs = getNodes(fanOut);
+        for (int k : ins)
+        {
+            saveRow(closure, k);
+            saveRow(other, k);
+        }
+        for (int l : outs)
+        {
+            saveRow(other, l);
+        }
+        for (int k : ins)
+        {
+            closure.orRow(k, fanOut);
+            other.clearRow(k, fanOut);
+        }
+        for (int l : outs)
+        {
+            other.clearRow(l, fanIn);
+        }
+    }
+
+    /*
+     * Longest path straight over the rows of one closure. A transitive edge never
+     * beats the path through its intermediate blocks, and in a closed relation a
+     * block has strictly more successors than any of them, so visiting the blocks
+     * by decreasing successor count is a topological order.
+     */
+    vector<float> findStarts(const BitMatrix &closure, const vector<int> &sizes, float &length) const
+    {
+        vector<pair<int, int>> order(numNodes);
+        for (int i = 0; i < numNodes; i++)
+        {
+            const uint64_t *r = closure.row(i);
+            int successors = 0;
+            for (int w = 0; w < wordsPerRow; w++)
+            {
+                successors += __builtin_popcountll(r[w]);
+            }
+            order[i] = {-successors, i};
+        }
+        sort(order.begin(), order.end());
+
+        vector<float> starts(numNodes, 0);
+        length = 0;
+        for (const pair<int, int> &entry : order)
+        {
+            int i = entry.second;
+            float end = starts[i] + sizes[i];
+            length = max(length, end);
+            const uint64_t *r = closure.row(i);
+            for (int w = 0; w < wordsPerRow; w++)
+            {
+                for (uint64_t bits = r[w]; bits; bits &= bits - 1)
+                {
+                    int j = w * 64 + __builtin_ctzll(bits);
+                    starts[j] = max(starts[j], end);
+                }
+            }
+        }
+        return starts;
+    }
+
+public:
+    // start from rows of about sqrt(n) blocks
+    TransitiveClosureGraph(int numNodes)
+        : numNodes(numNodes), wordsPerRow((numNodes + 63) / 64), horizontal(numNodes), vertical(numNodes)
+    {
+        savedStamps[0].assign(numNodes, 0);
+        savedStamps[1].assign(numNodes, 0);
+        int columns = max(1, static_cast<int>(ceil(sqrt(static_cast<double>(numNodes)))));
+        for (int a = 0; a < numNodes; a++)
+        {
+            for (int b = 0; b < numNodes; b++)
+            {
+                if (a / columns == b / columns && a < b)
+                {
+                    horizontal.set(a, b);
+                }
+                else if (a / columns < b / columns)
+                {
+                    vertical.set(a, b);
+                }
+            }
+        }
+    }
+
+    inline int size() const
+    {
+        return numNodes;
+    }
+
+    inline bool isLeftOf(int a, int b) const
+    {
+        return horizontal.get(a, b);
+    }
+
+    inline bool isBelow(int a, int b) const
+    {
+        return vertical.get(a, b);
+    }
+
+    // successors of i not reachable through another successor
+    vector<uint64_t> getReducedSuccessors(const BitMatrix &closure, int i) const
+    {
+        vector<uint64_t> reduced = closure.getRow(i);
+        for (int j : getNodes(reduced))
+        {
+            const uint64_t *r = closure.row(j);
+            for (int w = 0; w < wordsPerRow; w++)
+            {
+                reduced[w] &= ~r[w];
+            }
+        }
+        return reduced;
+    }
+
+    vector<int> getReducedSuccessors(bool isHorizontal, int i) const
+    {
+        return getNodes(getReducedSuccessors(isHorizontal ? horizontal : vertical, i));
+    }
+
+    // swap: exchange two blocks in both closures
+    inline void swapNodes(int a, int b)
+    {
+        horizontal.swapNodes(a, b);
+        vertical.swapNodes(a, b);
+    }
+
+    // reverse: turn the reduction edge (i, j) into (j, i) in the same closure
+    void reverseEdge(bool isHorizontal, int i, int j)
+    {
+        BitMatrix &closure = getMatrix(isHorizontal);
+        BitMatrix &other = getMatrix(!isHorizontal);
+        beginJournal();
+        saveRow(closure, i);
+        closure.reset(i, j);
+        vector<uint64_t> fanIn = closure.getColumn(j);
+        vector<uint64_t> fanOut = closure.getRow(i);
+        setBit(fanIn, j);
+        setBit(fanOut, i);
+        relate(closure, other, fanIn, fanOut);
+    }
+
+    // move: turn the reduction edge (i, j) into an edge of the other closure
+    void moveEdge(bool isHorizontal, int i, int j)
+    {
+        BitMatrix &closure = getMatrix(isHorizontal);
+        BitMatrix &other = getMatrix(!isHorizontal);
+        beginJournal();
+        saveRow(closure, i);
+        closure.reset(i, j);
+        vector<uint64_t> fanIn = other.getColumn(i);
+        vector<uint64_t> fanOut = other.getRow(j);
+        setBit(fanIn, i);
+        setBit(fanOut, j);
+        relate(other, closure, fanIn, fanOut);
+    }
+
+    // restore the rows the last reverseEdge or moveEdge changed
+    void undoEdge()
+    {
+        for (size_t s = 0; s < savedRows.size(); s++)
+        {
+            uint64_t *r = getMatrix(savedRows[s].first).row(savedRows[s].second);
+            copy(savedWords.begin() + s * wordsPerRow, savedWords.begin() + (s + 1) * wordsPerRow, r);
+        }
+        savedRows.clear();
+        savedWords.clear();
+    }
+
+    // lower-left corners and the bounding box
+    pair<float, float> pack(const vector<int> &widths, const vector<int> &heights, vector<int> &xs, vector<int> &ys) const
+    {
+        float width, height;
+        vector<float> startsX = findStarts(horizontal, widths, width);
+        vector<float> startsY = findStarts(vertical, heights, height);
+        for (int i = 0; i < numNodes; i++)
+        {
+            xs[i] = startsX[i];
+            ys[i] = startsY[i];
+        }
+        return {width, height};
+    }
+};
+
+#endif // TCG_HPP
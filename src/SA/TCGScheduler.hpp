@@ -0,0 +1,173 @@
+#ifndef TCGSCHEDULER_HPP
+#define TCGSCHEDULER_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include "Macro.hpp"
+#include "SchedulerBase.hpp"
+#include "TCG.hpp"
+
+using namespace std;
+
+enum TCGMoves
+{
+    TCG_ROTATE,
+    TCG_SWAP,
+    TCG_REVERSE,
+    TCG_MOVE
+};
+
+// Define a scheduler annealing over transitive closure graphs
+class TCGScheduler : public SchedulerBase
+{
+private:
+    TransitiveClosureGraph tcg;
+    vector<int> widths, heights, xs, ys;
+
+    TCGMoves previousMove;
+    pair<int, int> previousIndices;
+
+    // rotate: change dimensions
+    inline void rotate(int v, int aspectIndex = -1)
+    {
+        int originalIndex = macroDimensionsIndex[v];
+        if (aspectIndex == -1)
+        {
+            aspectIndex = (originalIndex + 1) % macroDimensions[v].size();
+        }
+        macroDimensionsIndex[v] = aspectIndex;
+        widths[v] = getWidth(v);
+        heights[v] = getHeight(v);
+        previousMove = TCG_ROTATE;
+        previousIndices = {v, originalIndex};
+    }
+
+    // swap: exchange two blocks in both closures
+    inline void swapNodes(int v1, int v2)
+    {
+        tcg.swapNodes(v1, v2);
+        previousMove = TCG_SWAP;
+        previousIndices = {v1, v2};
+    }
+
+    // reverse or move a random reduction edge leaving v, false if v has none
+    inline bool changeEdge(int v, bool reverse)
+    {
+        bool isHorizontal = getRandomNumber(0, 1) == 0;
+        vector<int> successors = tcg.getReducedSuccessors(isHorizontal, v);
+        if (successors.empty())
+        {
+            isHorizontal = !isHorizontal;
+            successors = tcg.getReducedSuccessors(isHorizontal, v);
+        }
+        if (successors.empty())
+        {
+            return false;
+        }
+        int target = successors[getRandomNumber(0, static_cast<int>(successors.size()) - 1)];
+        if (reverse)
+        {
+            tcg.reverseEdge(isHorizontal, v, target);
+        }
+        else
+        {
+            tcg.moveEdge(isHorizontal, v, target);
+        }
+        previousMove = reverse ? TCG_REVERSE : TCG_MOVE;
+        return true;
+    }
+
+public:
+    TCGScheduler(vector<Macro> &macros, float minAspectRatio, float maxAspectRatio, int k = 7, int timeLimit = 10)
+        : SchedulerBase(macros, minAspectRatio, maxAspectRatio, k, timeLimit),
+          tcg(numNodes),
+          widths(numNodes), heights(numNodes), xs(numNodes), ys(numNodes)
+    {
+        for (int i = 0; i < numNodes; i++)
+        {
+            widths[i] = getWidth(i);
+            heights[i] = getHeight(i);
+        }
+    }
+
+    // event handlers
+    inline void makeRandomModification()
+    {
+        countMove();
+        int v1 = getRandomNumber(0, numNodes - 1);
+        int v2 = getRandomNumber(0, numNodes - 1);
+        if (v1 == v2)
+        {
+            v2 = (v1 + 1) % numNodes;
+        }
+        // make a random modification to the current closure graphs (state)
+        int move = getRandomNumber(TCG_ROTATE, TCG_MOVE);
+        if (move == TCG_ROTATE && macroDimensions[v1].size() == 1)
+        {
+            move = getRandomNumber(TCG_SWAP, TCG_MOVE);
+        }
+        if (numNodes == 1)
+        {
+            move = TCG_ROTATE;
+        }
+        switch (move)
+        {
+        case TCG_ROTATE:
+            rotate(v1);
+            break;
+        case TCG_SWAP:
+            swapNodes(v1, v2);
+            break;
+        case TCG_REVERSE:
+        case TCG_MOVE:
+            // a block left of or below no other block has no edge to change
+            if (!changeEdge(v1, move == TCG_REVERSE))
+            {
+                swapNodes(v1, v2);
+            }
+            break;
+
+        default:
+            cerr << "Invalid move" << endl;
+            break;
+        }
+    }
+
+    inline double evaluateState()
+    {
+        pair<float, float> size = tcg.pack(widths, heights, xs, ys);
+        return max(size.first, size.second);
+    }
+
+    inline void reject()
+    {
+        rejectCount++;
+
+        switch (previousMove)
+        {
+        case TCG_ROTATE:
+            rotate(previousIndices.first, previousIndices.second);
+            break;
+        case TCG_SWAP:
+            swapNodes(previousIndices.first, previousIndices.second);
+            break;
+        case TCG_REVERSE:
+        case TCG_MOVE:
+            tcg.undoEdge();
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    void saveFloorplan(string filename)
+    {
+        pair<float, float> size = tcg.pack(widths, heights, xs, ys);
+        writeFloorplan(filename, xs, ys, size.first, size.second);
+    }
+};
+
+#endif // TCGSCHEDULER_HPP
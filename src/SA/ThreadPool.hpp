@@ -0,0 +1,173 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <algorithm>
+#include <memory>
+
+#include "CpuTopology.hpp"
+
+using namespace std;
+
+/*
+ * Fixed set of workers running one parallel loop at a time. The caller takes part in
+ * the loop and parallelFor returns once every index has been processed. Given cpus,
+ * thread i is pinned to cpus[i], the caller being thread 0 until the pool is gone.
+ */
+class ThreadPool
+{
+private:
+    vector<thread> workers;
+    mutex lock;
+    condition_variable wake, done;
+
+    // the loop being run, split into chunks claimed through next
+    function<void(int, int)> body;
+    int end = 0, chunk = 1;
+    atomic<int> next;
+    int busy = 0;
+    long long generation = 0;
+    bool stopping = false;
+    // every thread takes the same share of the loop, by its index, instead of claiming chunks
+    bool partitioned = false;
+    unique_ptr<CpuTopology::ScopedPin> callerPin;
+
+    void work(int index)
+    {
+        if (partitioned)
+        {
+            int threads = size();
+            int begin = static_cast<int>(static_cast<long long>(end) * index / threads);
+            int last = static_cast<int>(static_cast<long long>(end) * (index + 1) / threads);
+            if (begin < last)
+            {
+                body(begin, last);
+            }
+            return;
+        }
+        for (int begin = next.fetch_add(chunk); begin < end; begin = next.fetch_add(chunk))
+        {
+            body(begin, min(begin + chunk, end));
+        }
+    }
+
+    void loop(int index, int cpu)
+    {
+        if (cpu >= 0)
+        {
+            CpuTopology::pin(cpu);
+        }
+        long long seen = 0;
+        while (true)
+        {
+            {
+                unique_lock<mutex> guard(lock);
+                wake.wait(guard, [&]
+                          { return stopping || generation != seen; });
+                if (stopping)
+                {
+                    return;
+                }
+                seen = generation;
+            }
+            work(index);
+            {
+                lock_guard<mutex> guard(lock);
+                if (--busy == 0)
+                {
+                    done.notify_one();
+                }
+            }
+        }
+    }
+
+public:
+    // numThreads counts the caller, so 1 runs every loop inline
+    ThreadPool(int numThreads = thread::hardware_concurrency(), const vector<int> &cpus = vector<int>()) : next(0)
+    {
+        if (!cpus.empty())
+        {
+            callerPin.reset(new CpuTopology::ScopedPin(cpus[0]));
+        }
+        for (int i = 1; i < numThreads; i++)
+        {
+            workers.emplace_back(&ThreadPool::loop, this, i, cpus.empty() ? -1 : cpus[i % cpus.size()]);
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (thread &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    inline int size() const
+    {
+        return static_cast<int>(workers.size()) + 1;
+    }
+
+    // run body(begin, end) over chunks of [0, count)
+    void parallelFor(int count, int chunkSize, const function<void(int, int)> &function)
+    {
+        if (workers.empty() || count <= chunkSize)
+        {
+            if (count > 0)
+            {
+                function(0, count);
+            }
+            return;
+        }
+        start(count, chunkSize, false, function);
+    }
+
+    /*
+     * run body(begin, end) over [0, count) split evenly by thread index, so the same
+     * indices go to the same thread, and the same cpu, on every call with that count
+     */
+    void parallelForStatic(int count, const function<void(int, int)> &function)
+    {
+        if (workers.empty())
+        {
+            if (count > 0)
+            {
+                function(0, count);
+            }
+            return;
+        }
+        start(count, 1, true, function);
+    }
+
+private:
+    void start(int count, int chunkSize, bool split, const function<void(int, int)> &function)
+    {
+        {
+            lock_guard<mutex> guard(lock);
+            body = function;
+            end = count;
+            chunk = max(1, chunkSize);
+            partitioned = split;
+            next = 0;
+            busy = static_cast<int>(workers.size());
+            generation++;
+        }
+        wake.notify_all();
+        work(0);
+        unique_lock<mutex> guard(lock);
+        done.wait(guard, [&]
+                  { return busy == 0; });
+    }
+};
+
+#endif // THREADPOOL_HPP
@@ -0,0 +1,528 @@
+#ifndef WINDOWREPACKER_HPP
+#define WINDOWREPACKER_HPP
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <chrono>
+
+#include "CompactSequencePair.hpp"
+#include "ThreadPool.hpp"
+#include "../api.h"
+
+using namespace std;
+
+// blocks of the largest window
+const int REPACK_MAX_WINDOW = 8;
+// search nodes a window may visit before its search gives up, keeping the best found
+const long long REPACK_NODE_LIMIT = 1LL << 17;
+
+/*
+ * Large neighbourhood search after annealing. A window of the k blocks nearest to a
+ * seed block is ripped up and put back as a cluster of consecutive positions in
+ * both sequences. Every other block is then left of, right of, below or above the
+ * whole cluster at once, so the floorplan is the remaining sequence pair with one
+ * box in it: width max(Wout, Ax + w + Dx) and height max(Hout, Ay + h + Dy), with
+ * the arrivals and departures read off the remaining packing for each insertion
+ * point. The cluster's own sub-sequence pair and shapes are found by branch and
+ * bound over inserting its blocks one by one into both sequences, which only ever
+ * grows the partial box and so bounds the cost. Windows are searched in parallel
+ * against the same state, then applied greedily one by one while they improve it.
+ */
+class WindowRepacker
+{
+private:
+    struct Candidate
+    {
+        int insertX, insertY;
+        // the cost of the box is max(outside, w + spanX, h + spanY) over both sides
+        int spanX, spanY;
+    };
+
+    struct Repack
+    {
+        vector<int> blocks;
+        // local sequences of the cluster as blocks, and their shapes
+        vector<int> seqX, seqY, shapes;
+        int insertX = 0, insertY = 0;
+        double cost = numeric_limits<double>::infinity(), area = numeric_limits<double>::infinity();
+        bool limited = false;
+    };
+
+    // the search state of one window
+    struct Search
+    {
+        const vector<vector<pair<int, int>>> *dimensions;
+        vector<int> blocks;
+        vector<Candidate> candidates;
+        int outsideWidth, outsideHeight;
+
+        // partial cluster: order of the placed blocks in both sequences, shapes of all
+        vector<int> localX, localY, shapes;
+        vector<int> xs, ys;
+        long long nodes = 0;
+        Repack best;
+
+        // width and height of the placed blocks
+        pair<int, int> pack(int count)
+        {
+            vector<int> posX(count), posY(count);
+            for (int p = 0; p < count; p++)
+            {
+                posX[localX[p]] = p;
+                posY[localY[p]] = p;
+            }
+            int width = 0, height = 0;
+            for (int p = 0; p < count; p++)
+            {
+                int b = localX[p];
+                int x = 0;
+                for (int q = 0; q < p; q++)
+                {
+                    int a = localX[q];
+                    if (posY[a] < posY[b])
+                    {
+                        x = max(x, xs[a] + getWidth(a));
+                    }
+                }
+                xs[b] = x;
+                width = max(width, x + getWidth(b));
+            }
+            for (int p = 0; p < count; p++)
+            {
+                int b = localY[p];
+                int y = 0;
+                for (int q = 0; q < p; q++)
+                {
+                    int a = localY[q];
+                    // a below b: after b in X, before b in Y
+                    if (posX[a] > posX[b])
+                    {
+                        y = max(y, ys[a] + getHeight(a));
+                    }
+                }
+                ys[b] = y;
+                height = max(height, y + getHeight(b));
+            }
+            return {width, height};
+        }
+
+        inline int getWidth(int i) const
+        {
+            return (*dimensions)[blocks[i]][shapes[i]].first;
+        }
+
+        inline int getHeight(int i) const
+        {
+            return (*dimensions)[blocks[i]][shapes[i]].second;
+        }
+
+        // cost and bounding box area of the best insertion point for a box
+        void evaluate(int width, int height, double &cost, double &area, int &candidate) const
+        {
+            cost = area = numeric_limits<double>::infinity();
+            for (size_t c = 0; c < candidates.size(); c++)
+            {
+                double w = max(outsideWidth, width + candidates[c].spanX);
+                double h = max(outsideHeight, height + candidates[c].spanY);
+                double cCost = max(w, h), cArea = w * h;
+                if (cCost < cost || (cCost == cost && cArea < area))
+                {
+                    cost = cCost;
+                    area = cArea;
+                    candidate = static_cast<int>(c);
+                }
+            }
+        }
+
+        void branch(int count)
+        {
+            int k = static_cast<int>(blocks.size());
+            if (++nodes > REPACK_NODE_LIMIT)
+            {
+                best.limited = true;
+                return;
+            }
+            for (int px = 0; px <= count; px++)
+            {
+                localX.insert(localX.begin() + px, count);
+                for (int py = 0; py <= count; py++)
+                {
+                    localY.insert(localY.begin() + py, count);
+                    for (size_t s = 0; s < (*dimensions)[blocks[count]].size(); s++)
+                    {
+                        shapes[count] = static_cast<int>(s);
+                        pair<int, int> box = pack(count + 1);
+                        double cost, area;
+                        int candidate = 0;
+                        evaluate(box.first, box.second, cost, area, candidate);
+                        if (cost > best.cost || (cost == best.cost && area >= best.area))
+                        {
+                            continue;
+                        }
+                        if (count + 1 == k)
+                        {
+                            best.cost = cost;
+                            best.area = area;
+                            best.insertX = candidates[candidate].insertX;
+                            best.insertY = candidates[candidate].insertY;
+                            best.seqX.clear();
+                            best.seqY.clear();
+                            for (int p = 0; p < k; p++)
+                            {
+                                best.seqX.push_back(blocks[localX[p]]);
+                                best.seqY.push_back(blocks[localY[p]]);
+                            }
+                            best.shapes.assign(k, 0);
+                            for (int i = 0; i < k; i++)
+                            {
+                                best.shapes[i] = shapes[i];
+                            }
+                            continue;
+                        }
+                        branch(count + 1);
+                        if (best.limited)
+                        {
+                            break;
+                        }
+                    }
+                    localY.erase(localY.begin() + py);
+                    if (best.limited)
+                    {
+                        break;
+                    }
+                }
+                localX.erase(localX.begin() + px);
+                if (best.limited)
+                {
+                    break;
+                }
+            }
+        }
+    };
+
+    const vector<vector<pair<int, int>>> &dimensions;
+
+    inline void setShape(CompactSequencePair &state, vector<int> &shapes, int b, int shape) const
+    {
+        shapes[b] = shape;
+        state.setShape(b, dimensions[b][shape].first, dimensions[b][shape].second);
+    }
+
+    // the seed and its k - 1 nearest blocks by centre distance
+    static vector<int> pickWindow(int seed, int k, const vector<int> &xs, const vector<int> &ys, const CompactSequencePair &state)
+    {
+        int n = state.size();
+        vector<pair<double, int>> distances(n);
+        double cx = xs[seed] + state.widths[seed] / 2.0, cy = ys[seed] + state.heights[seed] / 2.0;
+        for (int b = 0; b < n; b++)
+        {
+            double dx = xs[b] + state.widths[b] / 2.0 - cx, dy = ys[b] + state.heights[b] / 2.0 - cy;
+            distances[b] = {b == seed ? -1 : dx * dx + dy * dy, b};
+        }
+        nth_element(distances.begin(), distances.begin() + (k - 1), distances.end());
+        vector<int> window;
+        for (int i = 0; i < k; i++)
+        {
+            window.push_back(distances[i].second);
+        }
+        return window;
+    }
+
+    // the state with the window taken out of both sequences
+    static void removeWindow(const CompactSequencePair &state, const vector<char> &inWindow, vector<int> &restX, vector<int> &restY)
+    {
+        restX.clear();
+        restY.clear();
+        for (int p = 0; p < state.size(); p++)
+        {
+            if (!inWindow[state.seqX[p]])
+            {
+                restX.push_back(state.seqX[p]);
+            }
+            if (!inWindow[state.seqY[p]])
+            {
+                restY.push_back(state.seqY[p]);
+            }
+        }
+    }
+
+    // the remaining sequences with the cluster inserted before the given positions
+    void insert(CompactSequencePair &state, vector<int> &shapes, const vector<int> &restX, const vector<int> &restY, const Repack &repack) const
+    {
+        int p = 0;
+        auto place = [&](const vector<int> &rest, const vector<int> &cluster, int at, vector<int> &seq, vector<int> &pos)
+        {
+            p = 0;
+            for (int i = 0; i <= static_cast<int>(rest.size()); i++)
+            {
+                if (i == at)
+                {
+                    for (int b : cluster)
+                    {
+                        seq[p] = b;
+                        pos[b] = p++;
+                    }
+                }
+                if (i < static_cast<int>(rest.size()))
+                {
+                    seq[p] = rest[i];
+                    pos[rest[i]] = p++;
+                }
+            }
+        };
+        place(restX, repack.seqX, repack.insertX, state.seqX, state.posX);
+        place(restY, repack.seqY, repack.insertY, state.seqY, state.posY);
+        for (size_t i = 0; i < repack.blocks.size(); i++)
+        {
+            setShape(state, shapes, repack.blocks[i], repack.shapes[i]);
+        }
+    }
+
+    /*
+     * Insertion points along one line: with the X insertion fixed, every Y insertion
+     * in one sweep of prefix and suffix maxima over the remaining Y sequence, and
+     * the other way around.
+     */
+    static void addCandidates(const CompactSequencePair &rest, const vector<int> &xs, const vector<int> &ys, const vector<int> &tailXs,
+                              const vector<int> &tailYs, int fixed, bool fixedX, vector<Candidate> &candidates)
+    {
+        int m = rest.size();
+        const vector<int> &order = fixedX ? rest.seqY : rest.seqX;
+        // before the fixed insertion in the other sequence
+        auto beforeFixed = [&](int o)
+        { return (fixedX ? rest.posX[o] : rest.posY[o]) < fixed; };
+        /*
+         * Swept over the other sequence, the blocks before the insertion there are
+         * left of the cluster when also before the fixed insertion, and below it
+         * (fixed X) or above it (fixed Y) otherwise. The blocks after it are right
+         * of the cluster when also after the fixed insertion, and above or below it
+         * otherwise.
+         */
+        vector<int> leftArrivals(m + 1, 0), prefixVertical(m + 1, 0), rightDepartures(m + 1, 0), suffixVertical(m + 1, 0);
+        for (int j = 0; j < m; j++)
+        {
+            int o = order[j];
+            leftArrivals[j + 1] = leftArrivals[j];
+            prefixVertical[j + 1] = prefixVertical[j];
+            if (beforeFixed(o))
+            {
+                leftArrivals[j + 1] = max(leftArrivals[j], xs[o] + rest.widths[o]);
+            }
+            else
+            {
+                int length = fixedX ? ys[o] + rest.heights[o] : tailYs[o] + rest.heights[o];
+                prefixVertical[j + 1] = max(prefixVertical[j], length);
+            }
+        }
+        for (int j = m - 1; j >= 0; j--)
+        {
+            int o = order[j];
+            rightDepartures[j] = rightDepartures[j + 1];
+            suffixVertical[j] = suffixVertical[j + 1];
+            if (!beforeFixed(o))
+            {
+                rightDepartures[j] = max(rightDepartures[j + 1], tailXs[o] + rest.widths[o]);
+            }
+            else
+            {
+                int length = fixedX ? tailYs[o] + rest.heights[o] : ys[o] + rest.heights[o];
+                suffixVertical[j] = max(suffixVertical[j + 1], length);
+            }
+        }
+        for (int i = 0; i <= m; i++)
+        {
+            Candidate candidate;
+            candidate.insertX = fixedX ? fixed : i;
+            candidate.insertY = fixedX ? i : fixed;
+            candidate.spanX = leftArrivals[i] + rightDepartures[i];
+            candidate.spanY = prefixVertical[i] + suffixVertical[i];
+            candidates.push_back(candidate);
+        }
+    }
+
+    // insertion points no other beats on both spans
+    static void keepPareto(vector<Candidate> &candidates)
+    {
+        sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b)
+             { return a.spanX < b.spanX || (a.spanX == b.spanX && a.spanY < b.spanY); });
+        vector<Candidate> front;
+        for (const Candidate &candidate : candidates)
+        {
+            if (front.empty() || candidate.spanY < front.back().spanY)
+            {
+                front.push_back(candidate);
+            }
+        }
+        candidates.swap(front);
+    }
+
+    Repack searchWindow(const CompactSequencePair &state, const vector<int> &window, double cost, double area) const
+    {
+        int n = state.size();
+        int k = static_cast<int>(window.size());
+        vector<char> inWindow(n, 0);
+        for (int b : window)
+        {
+            inWindow[b] = 1;
+        }
+        vector<int> restX, restY;
+        removeWindow(state, inWindow, restX, restY);
+        int m = n - k;
+
+        // the remaining sequence pair over local ids, forwards and backwards
+        CompactSequencePair rest(m), reversed(m);
+        vector<int> localId(n, -1);
+        for (int i = 0; i < m; i++)
+        {
+            localId[restX[i]] = i;
+        }
+        for (int i = 0; i < m; i++)
+        {
+            int bx = restX[i], by = restY[i];
+            rest.posX[localId[bx]] = i;
+            rest.posY[localId[by]] = i;
+            reversed.posX[localId[bx]] = m - 1 - i;
+            reversed.posY[localId[by]] = m - 1 - i;
+            rest.setShape(localId[bx], state.widths[bx], state.heights[bx]);
+            reversed.setShape(localId[bx], state.widths[bx], state.heights[bx]);
+        }
+        rest.updateSequences();
+        reversed.updateSequences();
+        vector<int> xs(m), ys(m), tailXs(m), tailYs(m);
+        Search search;
+        search.outsideWidth = rest.findWidth(&xs);
+        search.outsideHeight = rest.findHeight(&ys);
+        reversed.findWidth(&tailXs);
+        reversed.findHeight(&tailYs);
+
+        // lines through the positions the window blocks held, in the remaining sequences
+        vector<int> insertXs, insertYs;
+        for (int b : window)
+        {
+            int before = 0;
+            for (int p = 0; p < state.posX[b]; p++)
+            {
+                before += !inWindow[state.seqX[p]];
+            }
+            insertXs.push_back(before);
+            before = 0;
+            for (int p = 0; p < state.posY[b]; p++)
+            {
+                before += !inWindow[state.seqY[p]];
+            }
+            insertYs.push_back(before);
+        }
+        sort(insertXs.begin(), insertXs.end());
+        insertXs.erase(unique(insertXs.begin(), insertXs.end()), insertXs.end());
+        sort(insertYs.begin(), insertYs.end());
+        insertYs.erase(unique(insertYs.begin(), insertYs.end()), insertYs.end());
+        for (int ix : insertXs)
+        {
+            addCandidates(rest, xs, ys, tailXs, tailYs, ix, true, search.candidates);
+        }
+        for (int iy : insertYs)
+        {
+            addCandidates(rest, xs, ys, tailXs, tailYs, iy, false, search.candidates);
+        }
+        keepPareto(search.candidates);
+
+        // largest blocks first, so the partial boxes bound early
+        search.blocks = window;
+        sort(search.blocks.begin(), search.blocks.end(), [&](int a, int b)
+             { return state.widths[a] * state.heights[a] > state.widths[b] * state.heights[b]; });
+        search.dimensions = &dimensions;
+        search.shapes.assign(k, 0);
+        search.xs.assign(k, 0);
+        search.ys.assign(k, 0);
+        search.best.cost = cost;
+        search.best.area = area;
+        search.branch(0);
+        search.best.blocks = search.blocks;
+        return search.best;
+    }
+
+    static void measure(const CompactSequencePair &state, double &cost, double &area)
+    {
+        double width = state.findWidth(), height = state.findHeight();
+        cost = max(width, height);
+        area = width * height;
+    }
+
+public:
+    WindowRepacker(const vector<vector<pair<int, int>>> &dimensions) : dimensions(dimensions) {}
+
+    // repack windows of k blocks until a round improves nothing, or rounds are done
+    void run(CompactSequencePair &state, vector<int> &shapes, int k, int rounds, ThreadPool &pool, ostream &logFile) const
+    {
+        int n = state.size();
+        k = min(min(k, REPACK_MAX_WINDOW), n);
+        if (k < 2)
+        {
+            return;
+        }
+        double cost, area;
+        measure(state, cost, area);
+        logFile << "Window repacking: " << k << " blocks, cost " << cost << ", area " << area << endl;
+        auto begin = chrono::high_resolution_clock::now();
+
+        for (int round = 0; round < rounds && !API::task_cancel; round++)
+        {
+            vector<int> xs(n), ys(n);
+            state.findWidth(&xs);
+            state.findHeight(&ys);
+            vector<Repack> repacks(n);
+            pool.parallelFor(n, 1, [&](int first, int last)
+                             {
+                for (int seed = first; seed < last; seed++)
+                {
+                    repacks[seed] = searchWindow(state, pickWindow(seed, k, xs, ys, state), cost, area);
+                } });
+
+            // best predictions first, each checked on the state left by the ones before
+            sort(repacks.begin(), repacks.end(), [](const Repack &a, const Repack &b)
+                 { return a.cost < b.cost || (a.cost == b.cost && a.area < b.area); });
+            int found = 0, applied = 0, limited = 0;
+            for (const Repack &repack : repacks)
+            {
+                limited += repack.limited;
+                if (repack.seqX.empty())
+                {
+                    continue;
+                }
+                found++;
+                vector<char> inWindow(n, 0);
+                for (int b : repack.blocks)
+                {
+                    inWindow[b] = 1;
+                }
+                vector<int> restX, restY;
+                removeWindow(state, inWindow, restX, restY);
+                CompactSequencePair candidate = state;
+                vector<int> candidateShapes = shapes;
+                insert(candidate, candidateShapes, restX, restY, repack);
+                double newCost, newArea;
+                measure(candidate, newCost, newArea);
+                if (newCost < cost || (newCost == cost && newArea < area))
+                {
+                    state = candidate;
+                    shapes = candidateShapes;
+                    cost = newCost;
+                    area = newArea;
+                    applied++;
+                }
+            }
+            logFile << "Repack round " << round + 1 << ": " << found << " windows improved, " << applied << " applied, "
+                    << limited << " searches cut short, cost " << cost << ", area " << area << endl;
+            if (applied == 0)
+            {
+                break;
+            }
+        }
+        logFile << "Window repacking time: " << chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count() << "s" << endl;
+    }
+};
+
+#endif // WINDOWREPACKER_HPP
@@ -0,0 +1,559 @@
+#ifndef WINDOWEDSCHEDULER_HPP
+#define WINDOWEDSCHEDULER_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <random>
+#include <cmath>
+#include <iomanip>
+
+#include "Macro.hpp"
+#include "SchedulerBase.hpp"
+#include "CompactSequencePair.hpp"
+#include "ThreadPool.hpp"
+#include "../api.h"
+
+using namespace std;
+
+/*
+ * Domain decomposition for huge designs. Every iteration cuts the X sequence into
+ * windows of consecutive positions. Each window anneals the sub-sequence pair of
+ * its own blocks concurrently, permuting only the X and Y positions those blocks
+ * already hold, so the windows never write to the same slot. Y swaps stay within
+ * runs of consecutive positions, so every block keeps its relations to the blocks
+ * outside the window, and the blocks of a run share the same arrival and departure
+ * lengths from the rest of the floorplan. A window is evaluated as the longest
+ * paths through it with those lengths taken from the state it was cut from. At the
+ * temperature boundary every window is kept or dropped by the Metropolis criterion
+ * on that local evaluation, and the kept ones are merged together and evaluated
+ * on the whole floorplan at once; a batch the criterion rejects is rolled back and
+ * its halves tried alone. Window boundaries shift by half a window every other iteration so
+ * blocks mix across windows.
+ */
+class WindowedScheduler : public SchedulerBase
+{
+private:
+    struct Window
+    {
+        int start;
+        // global block of every local block, and the Y positions the window holds
+        vector<int> blocks, ySlots;
+        // run of consecutive Y positions every local block sits in
+        vector<int> runs;
+        vector<int> shapes, originalShapes;
+        CompactSequencePair local, original;
+        mt19937 generator;
+        long long accepted;
+        // local cost of the window as cut and as annealed
+        double originalCost, cost;
+        // lengths before and after every local block from outside the window
+        vector<int> arrivalsX, departuresX, arrivalsY, departuresY;
+    };
+
+    // maximum over prefixes of positions
+    class MaxTree
+    {
+    private:
+        vector<int> tree;
+
+    public:
+        void reset(int size)
+        {
+            tree.assign(size + 1, 0);
+        }
+
+        // maximum over the positions [0, p)
+        inline int query(int p) const
+        {
+            int result = 0;
+            for (; p > 0; p -= p & -p)
+            {
+                result = max(result, tree[p]);
+            }
+            return result;
+        }
+
+        inline void update(int p, int value)
+        {
+            for (p++; p < static_cast<int>(tree.size()); p += p & -p)
+            {
+                tree[p] = max(tree[p], value);
+            }
+        }
+    };
+
+    CompactSequencePair state, bestState;
+    vector<int> bestShapes;
+    double bestCost;
+
+    inline void setShape(CompactSequencePair &target, int v, int shapeIndex) const
+    {
+        target.setShape(v, macroDimensions[v][shapeIndex].first, macroDimensions[v][shapeIndex].second);
+    }
+
+    // rows filled up to the given width: X sequence by descending row, Y sequence by ascending row
+    void placeRows(double rowWidth)
+    {
+        vector<int> rowStarts(1, 0);
+        double width = 0;
+        for (int b = 0; b < numNodes; b++)
+        {
+            if (width > 0 && width + getWidth(b) > rowWidth)
+            {
+                rowStarts.push_back(b);
+                width = 0;
+            }
+            width += getWidth(b);
+        }
+        rowStarts.push_back(numNodes);
+
+        int p = 0;
+        for (int row = static_cast<int>(rowStarts.size()) - 2; row >= 0; row--)
+        {
+            for (int b = rowStarts[row]; b < rowStarts[row + 1]; b++)
+            {
+                state.posX[b] = p++;
+            }
+        }
+        for (int b = 0; b < numNodes; b++)
+        {
+            state.posY[b] = b;
+            setShape(state, b, macroDimensionsIndex[b]);
+        }
+        state.updateSequences();
+    }
+
+    // rows as wide as the side of a square of the total area, widened once to even out the sides
+    void initializeRows()
+    {
+        double area = 0;
+        for (int b = 0; b < numNodes; b++)
+        {
+            area += static_cast<double>(getWidth(b)) * getHeight(b);
+        }
+        placeRows(sqrt(area));
+        int width = state.findWidth();
+        int height = state.findHeight();
+        placeRows(sqrt(static_cast<double>(width) * height));
+    }
+
+    // take the blocks at X positions [start, end) and their Y positions as a sub-sequence pair
+    void extract(Window &window, int start, int end) const
+    {
+        int m = end - start;
+        window.start = start;
+        window.blocks.assign(state.seqX.begin() + start, state.seqX.begin() + end);
+        window.ySlots.resize(m);
+        window.runs.resize(m);
+        window.shapes.resize(m);
+        window.local = CompactSequencePair(m);
+        vector<pair<int, int>> byY(m);
+        for (int i = 0; i < m; i++)
+        {
+            int b = window.blocks[i];
+            byY[i] = {state.posY[b], i};
+            window.shapes[i] = macroDimensionsIndex[b];
+            window.local.setShape(i, state.widths[b], state.heights[b]);
+        }
+        sort(byY.begin(), byY.end());
+        int run = 0;
+        for (int r = 0; r < m; r++)
+        {
+            if (r > 0 && byY[r].first != byY[r - 1].first + 1)
+            {
+                run++;
+            }
+            window.ySlots[r] = byY[r].first;
+            window.runs[byY[r].second] = run;
+            window.local.posY[byY[r].second] = r;
+        }
+        window.local.updateSequences();
+        window.original = window.local;
+        window.originalShapes = window.shapes;
+        window.accepted = 0;
+    }
+
+    /*
+     * Arrival and departure lengths of every run from the current state. The blocks
+     * outside left of a run are those before the window in X and before the run in
+     * Y; a sweep over X answers the runs of all windows with one tree per side.
+     */
+    void findBoundaries(vector<Window> &windows)
+    {
+        vector<int> xs(numNodes), ys(numNodes), tailsX(numNodes), tailsY(numNodes);
+        state.findWidth(&xs);
+        state.findHeight(&ys);
+        MaxTree tree, otherTree;
+
+        // longest paths from the start of every block to the right and top sides
+        tree.reset(numNodes);
+        for (int i = numNodes - 1; i >= 0; i--)
+        {
+            int b = state.seqX[i];
+            tailsX[b] = state.widths[b] + tree.query(numNodes - 1 - state.posY[b]);
+            tree.update(numNodes - 1 - state.posY[b], tailsX[b]);
+        }
+        tree.reset(numNodes);
+        for (int i = numNodes - 1; i >= 0; i--)
+        {
+            int b = state.seqY[i];
+            tailsY[b] = state.heights[b] + tree.query(state.posX[b]);
+            tree.update(state.posX[b], tailsY[b]);
+        }
+
+        // blocks before the window in X: left of or above the run
+        tree.reset(numNodes);
+        otherTree.reset(numNodes);
+        int p = 0;
+        for (Window &window : windows)
+        {
+            for (; p < window.start; p++)
+            {
+                int c = state.seqX[p];
+                tree.update(state.posY[c], xs[c] + state.widths[c]);
+                otherTree.update(numNodes - 1 - state.posY[c], tailsY[c]);
+            }
+            setRunLengths(window, tree, otherTree, window.arrivalsX, window.departuresY);
+        }
+
+        // blocks after the window in X: right of or below the run
+        tree.reset(numNodes);
+        otherTree.reset(numNodes);
+        p = numNodes - 1;
+        for (int w = static_cast<int>(windows.size()) - 1; w >= 0; w--)
+        {
+            Window &window = windows[w];
+            for (; p >= window.start + window.local.size(); p--)
+            {
+                int c = state.seqX[p];
+                tree.update(state.posY[c], ys[c] + state.heights[c]);
+                otherTree.update(numNodes - 1 - state.posY[c], tailsX[c]);
+            }
+            setRunLengths(window, tree, otherTree, window.arrivalsY, window.departuresX);
+        }
+    }
+
+    // below: the maximum over Y positions under the run, above: over Y positions over it
+    void setRunLengths(const Window &window, const MaxTree &below, const MaxTree &above, vector<int> &fromBelow, vector<int> &fromAbove) const
+    {
+        int m = window.local.size();
+        fromBelow.resize(m);
+        fromAbove.resize(m);
+        for (int r = 0; r < m;)
+        {
+            int last = r;
+            while (last + 1 < m && window.ySlots[last + 1] == window.ySlots[last] + 1)
+            {
+                last++;
+            }
+            int lengthBelow = below.query(window.ySlots[r]);
+            int lengthAbove = above.query(numNodes - 1 - window.ySlots[last]);
+            for (int i = r; i <= last; i++)
+            {
+                int b = window.local.seqY[i];
+                fromBelow[b] = lengthBelow;
+                fromAbove[b] = lengthAbove;
+            }
+            r = last + 1;
+        }
+    }
+
+    // longest paths through the window, the rest of the floorplan held fixed
+    inline double evaluateWindow(const Window &window) const
+    {
+        return max(window.local.findWidth(window.arrivalsX, window.departuresX), window.local.findHeight(window.arrivalsY, window.departuresY));
+    }
+
+    void annealWindow(Window &window, int moves) const
+    {
+        CompactSequencePair &local = window.local;
+        int m = local.size();
+        if (m < 2)
+        {
+            window.originalCost = window.cost = evaluateWindow(window);
+            return;
+        }
+        uniform_int_distribution<int> pick(0, m - 1), pickMove(0, 3);
+        uniform_real_distribution<double> uniform(0.0, 1.0);
+        double cost = evaluateWindow(window);
+        window.originalCost = cost;
+        window.cost = cost;
+        // a chain ending uphill hands back the best state it went through
+        double bestCost = cost;
+        CompactSequencePair best = local;
+        vector<int> bestShapes = window.shapes;
+        for (int s = 0; s < moves; s++)
+        {
+            int v1 = pick(window.generator);
+            int v2 = pick(window.generator);
+            if (v1 == v2)
+            {
+                v2 = (v1 + 1) % m;
+            }
+            int move = pickMove(window.generator);
+            const vector<pair<int, int>> &shapes = macroDimensions[window.blocks[v1]];
+            int originalShape = window.shapes[v1];
+            if (move == 3 && shapes.size() == 1)
+            {
+                move = 2;
+            }
+            // a Y swap across a position of another window would change relations outside
+            if ((move == 1 || move == 2) && window.runs[v1] != window.runs[v2])
+            {
+                move = 0;
+            }
+            switch (move)
+            {
+            case 0:
+                local.swapX(v1, v2);
+                break;
+            case 1:
+                local.swapY(v1, v2);
+                break;
+            case 2:
+                local.swapBoth(v1, v2);
+                break;
+            default:
+                window.shapes[v1] = (originalShape + 1) % shapes.size();
+                local.setShape(v1, shapes[window.shapes[v1]].first, shapes[window.shapes[v1]].second);
+                break;
+            }
+
+            double newCost = evaluateWindow(window);
+            if (newCost <= cost || exp((cost - newCost) / temperature) > uniform(window.generator))
+            {
+                cost = newCost;
+                window.accepted++;
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    best = local;
+                    bestShapes = window.shapes;
+                }
+                continue;
+            }
+            switch (move)
+            {
+            case 0:
+                local.swapX(v1, v2);
+                break;
+            case 1:
+                local.swapY(v1, v2);
+                break;
+            case 2:
+                local.swapBoth(v1, v2);
+                break;
+            default:
+                window.shapes[v1] = originalShape;
+                local.setShape(v1, shapes[originalShape].first, shapes[originalShape].second);
+                break;
+            }
+        }
+        if (cost > bestCost)
+        {
+            local = best;
+            window.shapes = bestShapes;
+            cost = bestCost;
+        }
+        window.cost = cost;
+    }
+
+    // write a window state back into the slots it was taken from
+    void merge(const Window &window, const CompactSequencePair &local, const vector<int> &shapes)
+    {
+        for (int i = 0; i < local.size(); i++)
+        {
+            int b = window.blocks[local.seqX[i]];
+            state.seqX[window.start + i] = b;
+            state.posX[b] = window.start + i;
+
+            b = window.blocks[local.seqY[i]];
+            state.seqY[window.ySlots[i]] = b;
+            state.posY[b] = window.ySlots[i];
+        }
+        for (int i = 0; i < local.size(); i++)
+        {
+            int b = window.blocks[i];
+            macroDimensionsIndex[b] = shapes[i];
+            setShape(state, b, shapes[i]);
+        }
+    }
+
+public:
+    WindowedScheduler(vector<Macro> &macros, float minAspectRatio, float maxAspectRatio, int k = 7, int timeLimit = 10)
+        : SchedulerBase(macros, minAspectRatio, maxAspectRatio, k, timeLimit), state(numNodes)
+    {
+        initializeRows();
+        bestState = state;
+        bestShapes = macroDimensionsIndex;
+        bestCost = state.evaluate();
+    }
+
+    inline double evaluateState()
+    {
+        return state.evaluate();
+    }
+
+    void run(ostream &logFile, const API::Parameters &parm)
+    {
+        temperature = parm.temperature;
+        coolingRate = parm.coolingRate;
+        int windowSize = max(2, parm.windowSize);
+        int targetIterations = parm.targetIterations > 0 ? parm.targetIterations : log2(parm.absoluteTemperature / temperature) / log2(coolingRate);
+        int threads = max(1, parm.threads);
+        CpuTopology topology;
+        if (parm.pinThreads)
+        {
+            topology.describe(logFile);
+        }
+        ThreadPool pool(threads, parm.pinThreads ? topology.getPlacements(threads) : vector<int>());
+        logFile << "windowSize: " << windowSize << ", threads: " << pool.size() << endl;
+        logFile << "targetIterations: " << targetIterations << endl;
+
+        double currentCost = bestCost;
+        logFile << "Initial cost: " << currentCost << endl;
+        logFile << setw(10) << "Time" << setw(10) << "Steps" << setw(20) << "Cost" << endl;
+
+        long long steps = 0, accepted = 0, mergedWindows = 0, windowCount = 0, evaluations = 0;
+        double parallelSeconds = 0, serialSeconds = 0;
+        auto begin = chrono::high_resolution_clock::now();
+        vector<Window> windows;
+        for (int iteration = 0; iteration < targetIterations; iteration++)
+        {
+            // windows [offset + w * size, offset + (w + 1) * size), the first one cut short
+            int offset = iteration % 2 ? windowSize / 2 : 0;
+            vector<int> starts(1, 0);
+            for (int p = offset > 0 ? offset : windowSize; p < numNodes; p += windowSize)
+            {
+                starts.push_back(p);
+            }
+            starts.push_back(numNodes);
+            int numWindows = static_cast<int>(starts.size()) - 1;
+            windows.resize(numWindows);
+            windowCount += numWindows;
+            for (int w = 0; w < numWindows; w++)
+            {
+                windows[w].generator.seed(generator());
+            }
+            auto phase = chrono::high_resolution_clock::now();
+            // a window is extracted by the thread annealing it, so its workspace is local to that thread
+            pool.parallelForStatic(numWindows, [&](int first, int last)
+                                   {
+                for (int w = first; w < last; w++)
+                {
+                    extract(windows[w], starts[w], starts[w + 1]);
+                } });
+            parallelSeconds += chrono::duration<double>(chrono::high_resolution_clock::now() - phase).count();
+            phase = chrono::high_resolution_clock::now();
+            findBoundaries(windows);
+            serialSeconds += chrono::duration<double>(chrono::high_resolution_clock::now() - phase).count();
+            phase = chrono::high_resolution_clock::now();
+
+            pool.parallelForStatic(numWindows, [&](int first, int last)
+                                   {
+                for (int w = first; w < last; w++)
+                {
+                    annealWindow(windows[w], 2 * windows[w].local.size() * k);
+                } });
+            parallelSeconds += chrono::duration<double>(chrono::high_resolution_clock::now() - phase).count();
+            phase = chrono::high_resolution_clock::now();
+
+            /*
+             * Reconcile in one pass. With the rest of the floorplan as cut, a window off
+             * the critical paths leaves the cost at max(current, its local cost) and a
+             * critical one moves it to its local cost at best, so each window is judged
+             * on that estimate. A window shares rows and columns with its neighbours
+             * that its own evaluator cannot see, so the kept windows are checked
+             * together on the whole floorplan.
+             */
+            vector<int> kept;
+            for (int w = 0; w < numWindows; w++)
+            {
+                steps += 2LL * windows[w].local.size() * k;
+                accepted += windows[w].accepted;
+                double estimate = windows[w].originalCost < currentCost ? max(currentCost, windows[w].cost) : windows[w].cost;
+                if (estimate <= currentCost || exp((currentCost - estimate) / temperature) > getRandomNumber(0.0f, 1.0f))
+                {
+                    kept.push_back(w);
+                }
+            }
+            // a rejected batch is halved and each half tried alone, so a few bad windows cost a few evaluations
+            vector<pair<int, int>> batches(1, make_pair(0, static_cast<int>(kept.size())));
+            while (!batches.empty())
+            {
+                int first = batches.back().first, last = batches.back().second;
+                batches.pop_back();
+                if (first == last)
+                {
+                    continue;
+                }
+                for (int i = first; i < last; i++)
+                {
+                    merge(windows[kept[i]], windows[kept[i]].local, windows[kept[i]].shapes);
+                }
+                evaluations++;
+                double newCost = state.evaluate();
+                if (newCost <= currentCost || exp((currentCost - newCost) / temperature) > getRandomNumber(0.0f, 1.0f))
+                {
+                    currentCost = newCost;
+                    mergedWindows += last - first;
+                    continue;
+                }
+                for (int i = first; i < last; i++)
+                {
+                    merge(windows[kept[i]], windows[kept[i]].original, windows[kept[i]].originalShapes);
+                }
+                if (last - first > 1)
+                {
+                    int middle = (first + last) / 2;
+                    batches.push_back(make_pair(middle, last));
+                    batches.push_back(make_pair(first, middle));
+                }
+            }
+            serialSeconds += chrono::duration<double>(chrono::high_resolution_clock::now() - phase).count();
+            if (currentCost < bestCost)
+            {
+                bestCost = currentCost;
+                bestState = state;
+                bestShapes = macroDimensionsIndex;
+            }
+            temperature *= coolingRate;
+
+            logFile << setw(10) << getElapsed() << setw(10) << steps << setw(20) << bestCost << endl;
+            API::task_progress = (float)(iteration + 1) / targetIterations;
+            if (API::task_cancel)
+            {
+                logFile << "Task cancelled" << endl;
+                break;
+            }
+            if (hasTimeExpired())
+            {
+                logFile << "Time expired" << endl;
+                break;
+            }
+        }
+
+        double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count();
+        if (seconds > 0)
+        {
+            logFile << "Moves per second: " << steps / seconds << endl;
+        }
+        logFile << "Accepted window moves: " << accepted << "/" << steps << endl;
+        logFile << "Merged windows: " << mergedWindows << "/" << windowCount << ", floorplan evaluations: " << evaluations << endl;
+        logFile << "Window phase: " << parallelSeconds << "s, serial phase: " << serialSeconds << "s" << endl;
+        logFile << "Result: " << bestCost << endl;
+    }
+
+    void saveFloorplan(string filename)
+    {
+        macroDimensionsIndex = bestShapes;
+        vector<int> xs(numNodes), ys(numNodes);
+        int width = bestState.findWidth(&xs);
+        int height = bestState.findHeight(&ys);
+        writeFloorplan(filename, xs, ys, width, height);
+    }
+};
+
+#endif // WINDOWEDSCHEDULER_HPP
@@ -0,0 +1,515 @@
+#ifndef WORKERPROCESSES_HPP
+#define WORKERPROCESSES_HPP
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HAS_WORKER_PROCESSES 1
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <functional>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#endif
+
+#include "SimulatedAnnealing.hpp"
+#include "CompactSequencePair.hpp"
+#include "CpuTopology.hpp"
+#include "../api.h"
+
+using namespace std;
+
+extern char **environ;
+
+// first argument of a worker process started from this executable
+const char WORKER_ARGUMENT[] = "--sa-worker";
+// times a worker slot is restarted after a crash or a stall
+const int WORKER_RESTARTS = 3;
+
+/*
+ * One slot per worker in a shared memory segment, after a header with the
+ * parameters of the run. A slot has a single writer, its worker, and is guarded by
+ * a seqlock: the sequence is odd while a write is in progress, and a reader
+ * retries until it sees the same even sequence on both sides of its copy. Neither
+ * side ever blocks the other.
+ */
+class SharedSlots
+{
+public:
+    struct Progress
+    {
+        int iterations = 0;
+        int done = 0;
+        double currentCost = numeric_limits<double>::infinity();
+        double bestCost = numeric_limits<double>::infinity();
+    };
+
+private:
+    struct Header
+    {
+        int numSlots, numNodes;
+        API::Parameters parameters;
+    };
+
+    struct Slot
+    {
+        atomic<uint32_t> sequence;
+        Progress progress;
+        // followed by X positions, Y positions and shape indices of the best state
+    };
+
+    static const size_t headerSize = (sizeof(Header) + 63) / 64 * 64;
+
+    string name;
+    bool owner;
+    int numSlots, numNodes;
+    size_t slotSize, size;
+    char *memory;
+
+    inline Header *getHeader() const
+    {
+        return reinterpret_cast<Header *>(memory);
+    }
+
+    inline Slot *getSlot(int i) const
+    {
+        return reinterpret_cast<Slot *>(memory + headerSize + i * slotSize);
+    }
+
+    inline int32_t *getState(int i) const
+    {
+        return reinterpret_cast<int32_t *>(memory + headerSize + i * slotSize + sizeof(Slot));
+    }
+
+    inline void setSizes()
+    {
+        slotSize = (sizeof(Slot) + 3 * numNodes * sizeof(int32_t) + 63) / 64 * 64;
+        size = headerSize + slotSize * numSlots;
+    }
+
+    void map(int fd)
+    {
+        void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            if (owner)
+            {
+                shm_unlink(name.c_str());
+            }
+            throw runtime_error("Could not map shared memory");
+        }
+        memory = static_cast<char *>(mapping);
+    }
+
+public:
+    // create the segment of a run, unlinked when the run ends
+    SharedSlots(int numSlots, int numNodes, const API::Parameters &parameters) : owner(true), numSlots(numSlots), numNodes(numNodes)
+    {
+        static atomic<int> runs(0);
+        setSizes();
+        name = "/sa_demo_" + to_string(getpid()) + "_" + to_string(runs++);
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0)
+        {
+            throw runtime_error("Could not create shared memory");
+        }
+        if (ftruncate(fd, size) != 0)
+        {
+            close(fd);
+            shm_unlink(name.c_str());
+            throw runtime_error("Could not size shared memory");
+        }
+        map(fd);
+        Header *header = new (getHeader()) Header();
+        header->numSlots = numSlots;
+        header->numNodes = numNodes;
+        header->parameters = parameters;
+        for (int i = 0; i < numSlots; i++)
+        {
+            reset(i);
+        }
+    }
+
+    // open the segment of the run a worker process was started for
+    explicit SharedSlots(const string &name) : name(name), owner(false)
+    {
+        int fd = shm_open(name.c_str(), O_RDWR, 0600);
+        if (fd < 0)
+        {
+            throw runtime_error("Could not open shared memory");
+        }
+        Header header;
+        if (pread(fd, &header, sizeof(Header), 0) != static_cast<ssize_t>(sizeof(Header)))
+        {
+            close(fd);
+            throw runtime_error("Could not read shared memory");
+        }
+        numSlots = header.numSlots;
+        numNodes = header.numNodes;
+        setSizes();
+        map(fd);
+    }
+
+    ~SharedSlots()
+    {
+        munmap(memory, size);
+        if (owner)
+        {
+            shm_unlink(name.c_str());
+        }
+    }
+
+    inline const string &getName() const
+    {
+        return name;
+    }
+
+    inline int getNumNodes() const
+    {
+        return numNodes;
+    }
+
+    inline const API::Parameters &getParameters() const
+    {
+        return getHeader()->parameters;
+    }
+
+    // only while no worker writes to the slot
+    void reset(int i)
+    {
+        Slot *slot = new (getSlot(i)) Slot();
+        slot->sequence.store(0, memory_order_relaxed);
+        slot->progress = Progress();
+    }
+
+    // state is null when only the progress changed
+    void write(int i, const Progress &progress, const CompactSequencePair *state, const vector<int> *shapeIndices)
+    {
+        Slot *slot = getSlot(i);
+        uint32_t sequence = slot->sequence.load(memory_order_relaxed);
+        slot->sequence.store(sequence + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        slot->progress = progress;
+        if (state)
+        {
+            int32_t *data = getState(i);
+            copy(state->posX.begin(), state->posX.end(), data);
+            copy(state->posY.begin(), state->posY.end(), data + numNodes);
+            copy(shapeIndices->begin(), shapeIndices->end(), data + 2 * numNodes);
+        }
+        atomic_thread_fence(memory_order_release);
+        slot->sequence.store(sequence + 2, memory_order_release);
+    }
+
+    // state is null to read the progress only
+    void read(int i, Progress &progress, CompactSequencePair *state, vector<int> *shapeIndices) const
+    {
+        Slot *slot = getSlot(i);
+        while (true)
+        {
+            uint32_t before = slot->sequence.load(memory_order_acquire);
+            if (before & 1)
+            {
+                this_thread::yield();
+                continue;
+            }
+            progress = slot->progress;
+            if (state)
+            {
+                const int32_t *data = getState(i);
+                state->posX.assign(data, data + numNodes);
+                state->posY.assign(data + numNodes, data + 2 * numNodes);
+                shapeIndices->assign(data + 2 * numNodes, data + 3 * numNodes);
+            }
+            atomic_thread_fence(memory_order_acquire);
+            if (slot->sequence.load(memory_order_relaxed) == before)
+            {
+                return;
+            }
+        }
+    }
+};
+
+/*
+ * Starts one process per worker, each annealing its own scheduler from its own seed
+ * and publishing its progress every iteration and its best state on improvement.
+ * The coordinator polls the slots, keeps the best state seen, and kills and
+ * restarts workers that crash or make no progress for stallTimeout seconds.
+ *
+ * The coordinator runs in a process with other threads, where a forked child may
+ * only call async-signal-safe functions until it execs. A worker is therefore this
+ * executable started again with posix_spawn and WORKER_ARGUMENT, which main hands
+ * to API::runWorker before any thread exists; the worker opens the segment by
+ * name, reads the parameters from its header, loads the input and calls work.
+ */
+template <class SchedulerType>
+class WorkerProcesses
+{
+private:
+    struct Worker
+    {
+        pid_t pid = -1;
+        unsigned seed = 0;
+        int restarts = 0;
+        int lastIterations = -1;
+        bool finished = false;
+        chrono::steady_clock::time_point lastProgress;
+    };
+
+    const API::Parameters &parm;
+    SharedSlots slots;
+    vector<Worker> workers;
+    mt19937 seeds;
+    CpuTopology topology;
+    string executable;
+
+    static string getExecutable()
+    {
+#ifdef __APPLE__
+        char path[4096];
+        uint32_t length = sizeof(path);
+        if (_NSGetExecutablePath(path, &length) != 0)
+        {
+            throw runtime_error("Could not find the executable");
+        }
+        return path;
+#else
+        char path[4096];
+        ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+        if (length <= 0)
+        {
+            throw runtime_error("Could not find the executable");
+        }
+        return string(path, length);
+#endif
+    }
+
+    void spawn(int i)
+    {
+        Worker &worker = workers[i];
+        slots.reset(i);
+        worker.seed = seeds();
+        worker.lastIterations = -1;
+        worker.lastProgress = chrono::steady_clock::now();
+        string slot = to_string(i), seed = to_string(worker.seed);
+        char *argv[] = {const_cast<char *>(executable.c_str()), const_cast<char *>(WORKER_ARGUMENT), const_cast<char *>(slots.getName().c_str()),
+                        const_cast<char *>(slot.c_str()), const_cast<char *>(seed.c_str()), const_cast<char *>(API::logFileName.c_str()), nullptr};
+        pid_t pid;
+        if (posix_spawn(&pid, executable.c_str(), nullptr, nullptr, argv, environ) != 0)
+        {
+            worker.finished = true;
+            return;
+        }
+        worker.pid = pid;
+    }
+
+public:
+    WorkerProcesses(int numNodes, const API::Parameters &parm)
+        : parm(parm), slots(max(1, parm.workers), numNodes, parm), workers(max(1, parm.workers)), seeds(random_device()()), executable(getExecutable())
+    {
+    }
+
+    // the worker process of slot i: anneal from seed and publish, returns the exit status
+    static int work(SharedSlots &slots, int i, unsigned seed, const function<SchedulerType *()> &createScheduler, const string &logFileName)
+    {
+        const API::Parameters &parm = slots.getParameters();
+        // pinned before the scheduler exists, so its memory is first touched on the local node
+        if (parm.pinThreads)
+        {
+            CpuTopology topology;
+            CpuTopology::pin(topology.getPlacement(i));
+        }
+        unique_ptr<SchedulerType> scheduler(createScheduler());
+        scheduler->setSeed(seed);
+        ofstream logFile(logFileName + ".worker" + to_string(i));
+
+        API::Parameters workerParm = parm;
+        workerParm.threads = 1;
+        workerParm.migrationInterval = 1;
+        SharedSlots::Progress progress;
+        auto publish = [&](double &currentCost)
+        {
+            progress.iterations++;
+            progress.currentCost = currentCost;
+            if (currentCost < progress.bestCost)
+            {
+                progress.bestCost = currentCost;
+                CompactSequencePair state = scheduler->getCompactState();
+                slots.write(i, progress, &state, &scheduler->getShapeIndices());
+                return;
+            }
+            slots.write(i, progress, nullptr, nullptr);
+        };
+        SA::run(*scheduler, logFile, workerParm, publish);
+
+        double cost = scheduler->computeCost();
+        progress.done = 1;
+        progress.currentCost = cost;
+        if (cost < progress.bestCost)
+        {
+            progress.bestCost = cost;
+            CompactSequencePair state = scheduler->getCompactState();
+            slots.write(i, progress, &state, &scheduler->getShapeIndices());
+        }
+        else
+        {
+            slots.write(i, progress, nullptr, nullptr);
+        }
+        logFile.close();
+        return 0;
+    }
+
+    // run the workers to completion, then load the best state seen into scheduler
+    void run(SchedulerType &scheduler, ostream &logFile)
+    {
+        int numWorkers = static_cast<int>(workers.size());
+        int targetIterations = parm.targetIterations > 0 ? parm.targetIterations : log2(parm.absoluteTemperature / parm.temperature) / log2(parm.coolingRate);
+        if (parm.pinThreads)
+        {
+            topology.describe(logFile);
+        }
+        for (int i = 0; i < numWorkers; i++)
+        {
+            spawn(i);
+        }
+
+        double bestCost = numeric_limits<double>::infinity();
+        CompactSequencePair bestState(scheduler.getNumNodes()), state(scheduler.getNumNodes());
+        vector<int> bestShapes, shapes;
+        int bestWorker = -1;
+        bool cancelled = false;
+        auto start = chrono::steady_clock::now();
+
+        int running = numWorkers;
+        while (running > 0)
+        {
+            this_thread::sleep_for(chrono::milliseconds(100));
+            if (API::task_cancel && !cancelled)
+            {
+                cancelled = true;
+                for (Worker &worker : workers)
+                {
+                    if (!worker.finished)
+                    {
+                        kill(worker.pid, SIGKILL);
+                    }
+                }
+            }
+
+            running = 0;
+            float progressSum = 0;
+            auto now = chrono::steady_clock::now();
+            for (int i = 0; i < numWorkers; i++)
+            {
+                Worker &worker = workers[i];
+                SharedSlots::Progress progress;
+                slots.read(i, progress, &state, &shapes);
+                if (progress.bestCost < bestCost)
+                {
+                    bestCost = progress.bestCost;
+                    bestState = state;
+                    bestShapes = shapes;
+                    bestWorker = i;
+                }
+                progressSum += min(1.0f, (float)progress.iterations / max(1, targetIterations));
+                if (worker.finished)
+                {
+                    continue;
+                }
+
+                int status;
+                if (waitpid(worker.pid, &status, WNOHANG) == worker.pid)
+                {
+                    // the worker may have published its result between the read above and its exit
+                    slots.read(i, progress, &state, &shapes);
+                    if (progress.bestCost < bestCost)
+                    {
+                        bestCost = progress.bestCost;
+                        bestState = state;
+                        bestShapes = shapes;
+                        bestWorker = i;
+                    }
+                    bool crashed = !progress.done && !(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+                    if (crashed && !cancelled && worker.restarts < WORKER_RESTARTS)
+                    {
+                        logFile << "Worker " << i << " exited early, restarting" << endl;
+                        worker.restarts++;
+                        spawn(i);
+                        running++;
+                        continue;
+                    }
+                    worker.finished = true;
+                    continue;
+                }
+                running++;
+
+                if (progress.iterations != worker.lastIterations)
+                {
+                    worker.lastIterations = progress.iterations;
+                    worker.lastProgress = now;
+                }
+                else if (parm.stallTimeout > 0 && !cancelled && now - worker.lastProgress > chrono::seconds(parm.stallTimeout))
+                {
+                    kill(worker.pid, SIGKILL);
+                    waitpid(worker.pid, &status, 0);
+                    if (worker.restarts < WORKER_RESTARTS)
+                    {
+                        logFile << "Worker " << i << " stalled at iteration " << progress.iterations << ", restarting" << endl;
+                        worker.restarts++;
+                        spawn(i);
+                    }
+                    else
+                    {
+                        logFile << "Worker " << i << " stalled at iteration " << progress.iterations << ", stopped" << endl;
+                        worker.finished = true;
+                    }
+                }
+            }
+            API::task_progress = progressSum / numWorkers;
+        }
+
+        for (int i = 0; i < numWorkers; i++)
+        {
+            SharedSlots::Progress progress;
+            slots.read(i, progress, nullptr, nullptr);
+            logFile << "Worker " << i << " (seed " << workers[i].seed << "): best " << progress.bestCost
+                    << ", iterations " << progress.iterations << ", restarts " << workers[i].restarts << endl;
+        }
+        logFile << "Workers: " << numWorkers << ", best: " << bestCost << " from worker " << bestWorker << ", wall time: "
+                << chrono::duration<double>(chrono::steady_clock::now() - start).count() << "s" << endl;
+        if (cancelled)
+        {
+            logFile << "Task cancelled" << endl;
+        }
+
+        if (bestWorker >= 0)
+        {
+            bestState.updateSequences();
+            scheduler.loadCompactState(bestState, bestShapes);
+        }
+        logFile << "Result: " << scheduler.computeCost() << endl;
+    }
+};
+
+#endif
+
+#endif // WORKERPROCESSES_HPP
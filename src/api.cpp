@@ -1,7 +1,26 @@
 #include "api.h"
 #include "SA/SimulatedAnnealing.hpp"
 #include "SA/Macro.hpp"
+#include "SA/Netlist.hpp"
 #include "SA/Scheduler.hpp"
+#include "SA/BStarTreeScheduler.hpp"
+#include "SA/SlicingScheduler.hpp"
+#include "SA/TCGScheduler.hpp"
+#include "SA/SmallScheduler.hpp"
+#include "SA/IslandModel.hpp"
+#include "SA/WindowedScheduler.hpp"
+#include "SA/WorkerProcesses.hpp"
+#include "SA/ParameterSweep.hpp"
+#include "SA/GeneticScheduler.hpp"
+#include "SA/WindowRepacker.hpp"
+#include "SA/ExactSolver.hpp"
+#include "SA/SkylineSeeder.hpp"
+#include "SA/HierarchicalScheduler.hpp"
+#include "SA/MultilevelScheduler.hpp"
+
+// the skyline packer of SkylineSeeder, defined in this translation unit only
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imstb_rectpack.h"
 
 std::atomic<bool> API::task_running(false);
 std::atomic<bool> API::task_done(false);
@@ -38,7 +57,23 @@ static vector<string> split(string &str, char delim)
     return res;
 }
 
-static vector<Macro> getMacros(string filename, float &minAspectRatio, float &maxAspectRatio)
+// read a line without its trailing whitespace, so files with CRLF line endings parse the same
+static bool readLine(ifstream &file, string &line)
+{
+    if (!getline(file, line))
+    {
+        return false;
+    }
+    line.erase(line.find_last_not_of(" \t\r\n") + 1);
+    return true;
+}
+
+/*
+ * The blocks, optionally followed by the nets over them:
+ *   NumNets <count>
+ *   <net name> <block name> <block name> ...
+ */
+static vector<Macro> getMacros(string filename, float &minAspectRatio, float &maxAspectRatio, Netlist &netlist)
 {
     vector<Macro> macros;
     ifstream file(filename);
@@ -50,31 +85,358 @@ static vector<Macro> getMacros(string filename, float &minAspectRatio, float &ma
 
     string line;
     int nums;
-    getline(file, line);
+    readLine(file, line);
     vector<string> tokens = split(line, ' ');
     nums = stoi(tokens[1]);
-    getline(file, line);
+    readLine(file, line);
     tokens = split(line, ' ');
     minAspectRatio = stof(tokens[1]);
-    getline(file, line);
+    readLine(file, line);
     tokens = split(line, ' ');
     maxAspectRatio = stof(tokens[1]);
     for (int i = 0; i < nums; i++)
     {
-        getline(file, line);
+        readLine(file, line);
         vector<string> tokens = split(line, ' ');
         string name = tokens[0];
         int w = stoi(tokens[1]);
         int h = stoi(tokens[2]);
         macros.push_back(Macro(name, w, h));
     }
+
+    vector<vector<int>> nets;
+    vector<string> netNames;
+    if (readLine(file, line) && !line.empty())
+    {
+        tokens = split(line, ' ');
+        if (tokens.size() < 2 || tokens[0] != "NumNets")
+        {
+            throw runtime_error("Expected NumNets after the blocks");
+        }
+        unordered_map<string, int> blocks;
+        for (int i = 0; i < nums; i++)
+        {
+            blocks[macros[i].getName()] = i;
+        }
+        int numNets = stoi(tokens[1]);
+        for (int i = 0; i < numNets; i++)
+        {
+            if (!readLine(file, line) || line.empty())
+            {
+                throw runtime_error("Expected " + to_string(numNets) + " nets, found " + to_string(i));
+            }
+            tokens = split(line, ' ');
+            netNames.push_back(tokens[0]);
+            nets.push_back(vector<int>());
+            for (size_t t = 1; t < tokens.size(); t++)
+            {
+                if (tokens[t].empty())
+                {
+                    continue;
+                }
+                auto block = blocks.find(tokens[t]);
+                if (block == blocks.end())
+                {
+                    throw runtime_error("Unknown block " + tokens[t] + " in net " + tokens[0]);
+                }
+                nets.back().push_back(block->second);
+            }
+        }
+    }
+    netlist = Netlist(nums, nets, netNames);
     file.close();
 
     return macros;
 }
 
-void API::run(const Parameters &parameters)
+// search the optimum of a small design and log how far the result is from it
+static void reportOptimalityGap(const vector<vector<pair<int, int>>> &dimensions, double result, ofstream &logFile, const API::Parameters &parameters)
+{
+    if (dimensions.size() > EXACT_MAX_BLOCKS)
+    {
+        logFile << "Exact solver: designs of at most " << EXACT_MAX_BLOCKS << " blocks" << endl;
+        return;
+    }
+    ExactSolver solver(dimensions);
+    ThreadPool pool(max(1, parameters.threads));
+    auto start = chrono::steady_clock::now();
+    bool proven = solver.solve(static_cast<int>(ceil(result)), pool, parameters.exactTimeLimit);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    int optimum = solver.hasSolution() ? solver.getBestCost() : static_cast<int>(ceil(result));
+    logFile << "Exact solver: " << (proven ? "optimum " : "best found ") << optimum << ", lower bound " << solver.getLowerBound()
+            << ", nodes " << solver.getNodes() << ", " << seconds << "s" << endl;
+    logFile << "Optimality gap: " << 100.0 * (result - optimum) / optimum << "%" << (proven ? "" : " or more") << endl;
+}
+
+// plot the floorplan of an annealed scheduler
+template <class SchedulerType>
+static void finishRun(SchedulerType &scheduler, ofstream &logFile, const API::Parameters &parameters)
+{
+    if (parameters.exactSolve && scheduler.hasCompositeCost())
+    {
+        logFile << "Exact solver: skipped, it only minimises max(width, height)" << endl;
+    }
+    else if (parameters.exactSolve)
+    {
+        reportOptimalityGap(scheduler.getMacroDimensions(), scheduler.evaluateState(), logFile, parameters);
+    }
+    auto in_time_t = chrono::system_clock::to_time_t(chrono::system_clock::now());
+    logFile << "End time: " << put_time(localtime(&in_time_t), "%Y-%m-%d %H:%M:%S") << endl;
+
+    try
+    {
+        scheduler.saveFloorplan(parameters.outputFile);
+        std::system(("gnuplot " + string(parameters.outputFile)).c_str());
+    }
+    catch (exception &e)
+    {
+        logFile << "Error: " << e.what() << endl;
+        API::error_message = strdup(e.what());
+    }
+}
+
+// anneal with the given representation, then plot the resulting floorplan
+template <class SchedulerType>
+static void runScheduler(SchedulerType &scheduler, ofstream &logFile, const API::Parameters &parameters)
+{
+    SA::run(scheduler, logFile, parameters);
+    finishRun(scheduler, logFile, parameters);
+}
+
+// the nets and the fixed outline of a sequence pair, the outline clock started
+static void configureScheduler(Scheduler &scheduler, const Netlist &netlist, const API::Parameters &parameters)
+{
+    scheduler.setNetlist(netlist, parameters.wirelengthWeight);
+    scheduler.setOutline(parameters.dieWidth, parameters.dieHeight, parameters.outlinePenalty);
+}
+
+// move a sequence pair to the best skyline packing of its blocks, returns its cost
+static double seedSequencePair(Scheduler &scheduler)
+{
+    CompactSequencePair state;
+    vector<int> shapes;
+    SkylineSeeder seeder(scheduler.getMacroDimensions());
+    double cost = seeder.run(state, shapes);
+    scheduler.loadCompactState(state, shapes);
+    return cost;
+}
+
+// repack windows of an annealed sequence pair, then plot it
+static void finishSequencePair(Scheduler &scheduler, ofstream &logFile, const API::Parameters &parameters)
+{
+    if (parameters.repackWindow > 1)
+    {
+        CompactSequencePair original = scheduler.getCompactState();
+        vector<int> originalShapes = scheduler.getShapeIndices();
+        double originalCost = scheduler.computeCost();
+        CompactSequencePair state = original;
+        vector<int> shapes = originalShapes;
+        ThreadPool pool(max(1, parameters.threads));
+        WindowRepacker repacker(scheduler.getMacroDimensions());
+        repacker.run(state, shapes, parameters.repackWindow, parameters.repackRounds, pool, logFile);
+        scheduler.loadCompactState(state, shapes);
+        double cost = scheduler.computeCost();
+        // the repacker minimises max(width, height), which need not lower the wirelength or outline cost
+        if (cost >= originalCost)
+        {
+            if (cost > originalCost)
+            {
+                logFile << "Repack discarded: cost " << cost << " above " << originalCost << endl;
+            }
+            scheduler.loadCompactState(original, originalShapes);
+            cost = scheduler.computeCost();
+        }
+        logFile << "Result: " << cost << endl;
+    }
+    if (scheduler.hasNets())
+    {
+        logFile << "Wirelength: " << scheduler.getWirelength() << endl;
+    }
+    if (scheduler.hasOutline())
+    {
+        pair<float, float> size = scheduler.getSize();
+        logFile << "Outline: " << size.first << " x " << size.second << " in " << parameters.dieWidth << " x " << parameters.dieHeight
+                << (size.first <= parameters.dieWidth && size.second <= parameters.dieHeight ? ", fits" : ", violated") << endl;
+        if (scheduler.getFirstFeasible() < 0)
+        {
+            logFile << "First feasible: none" << endl;
+        }
+        else
+        {
+            logFile << "First feasible: " << scheduler.getFirstFeasible() << "s" << endl;
+        }
+    }
+    if (scheduler.getBoundedEvaluations() > 0)
+    {
+        logFile << "Early-stopped evaluations: " << scheduler.getEarlyStops() << "/" << scheduler.getBoundedEvaluations()
+                << " (" << 100.0 * scheduler.getEarlyStops() / scheduler.getBoundedEvaluations() << "%)" << endl;
+    }
+    finishRun(scheduler, logFile, parameters);
+}
+
+// anneal sequence pair islands in parallel, then plot the best one
+static void runIslands(vector<Macro> &macros, float minAspectRatio, float maxAspectRatio, const Netlist &netlist, ofstream &logFile, const API::Parameters &parameters)
+{
+    function<Scheduler *()> createScheduler = [&]()
+    {
+        Scheduler *scheduler = new Scheduler(macros, minAspectRatio, maxAspectRatio, parameters.movesFactor, 10, parameters.transitiveReduction);
+        configureScheduler(*scheduler, netlist, parameters);
+        if (parameters.skylineSeed)
+        {
+            seedSequencePair(*scheduler);
+        }
+        return scheduler;
+    };
+    vector<unique_ptr<Scheduler>> islands;
+    const char *topologies[] = {"ring", "fully connected"};
+    logFile << "Islands: " << parameters.islands << ", migration interval: " << parameters.migrationInterval
+            << ", topology: " << topologies[parameters.migrationTopology] << endl;
+    int best = IslandModel::run(islands, parameters.islands, createScheduler, logFile, parameters);
+    finishSequencePair(*islands[best], logFile, parameters);
+}
+
+// the sequence pair every worker process starts from
+static Scheduler *createWorkerScheduler(vector<Macro> &macros, float minAspectRatio, float maxAspectRatio, const Netlist &netlist, const API::Parameters &parameters)
+{
+    Scheduler *scheduler = new Scheduler(macros, minAspectRatio, maxAspectRatio, parameters.movesFactor, 10, parameters.transitiveReduction);
+    configureScheduler(*scheduler, netlist, parameters);
+    if (parameters.skylineSeed)
+    {
+        seedSequencePair(*scheduler);
+    }
+    return scheduler;
+}
+
+// anneal sequence pairs in worker processes, then plot the best one
+static void runWorkers(vector<Macro> &macros, float minAspectRatio, float maxAspectRatio, const Netlist &netlist, ofstream &logFile, const API::Parameters &parameters)
+{
+#ifdef HAS_WORKER_PROCESSES
+    unique_ptr<Scheduler> scheduler(createWorkerScheduler(macros, minAspectRatio, maxAspectRatio, netlist, parameters));
+    logFile << "Workers: " << parameters.workers << ", stall timeout: " << parameters.stallTimeout << "s" << endl;
+    try
+    {
+        WorkerProcesses<Scheduler> workers(static_cast<int>(macros.size()), parameters);
+        workers.run(*scheduler, logFile);
+    }
+    catch (exception &e)
+    {
+        logFile << "Error: " << e.what() << endl;
+        API::error_message = strdup(e.what());
+        return;
+    }
+    finishSequencePair(*scheduler, logFile, parameters);
+#else
+    logFile << "Error: worker processes need a POSIX system" << endl;
+    API::error_message = strdup("Worker processes need a POSIX system");
+#endif
+}
+
+// sweep the schedule of one representation, then plot the best floorplan found
+template <class SchedulerType>
+static void runSweep(const function<SchedulerType *(int)> &createScheduler, ofstream &logFile, const API::Parameters &parameters)
+{
+    unique_ptr<SchedulerType> best;
+    try
+    {
+        ParameterSweep::run(createScheduler, best, logFile, parameters);
+    }
+    catch (exception &e)
+    {
+        logFile << "Error: " << e.what() << endl;
+        API::error_message = strdup(e.what());
+    }
+    if (best)
+    {
+        finishRun(*best, logFile, parameters);
+    }
+}
+
+// the fixed-size sequence pair of N blocks, kept between runs on the same input like the graph-based one
+template <int N>
+static void runSmallScheduler(vector<Macro> &macros, float minAspectRatio, float maxAspectRatio, int input, ofstream &logFile, const API::Parameters &parameters)
+{
+    static unique_ptr<SmallScheduler<N>> scheduler;
+    static int lastInput = -1, lastMovesFactor = 0;
+    bool continued = scheduler && lastInput == input && lastMovesFactor == parameters.movesFactor;
+    if (!continued)
+    {
+        scheduler.reset(new SmallScheduler<N>(macros, minAspectRatio, maxAspectRatio, parameters.movesFactor));
+        lastInput = input;
+        lastMovesFactor = parameters.movesFactor;
+    }
+    logFile << "Sequence pair: compact, " << N << " blocks" << (continued ? ", continued" : "") << endl;
+    runScheduler(*scheduler, logFile, parameters);
+}
+
+// small designs without any option the fixed-size sequence pairs ignore run on them, input counts the inputs loaded
+static bool runSmallScheduler(vector<Macro> &macros, float minAspectRatio, float maxAspectRatio, int input, ofstream &logFile, const API::Parameters &parameters)
+{
+    size_t numNodes = macros.size();
+    if (numNodes > 64 || parameters.transitiveReduction || parameters.threads > 1 || parameters.criticalMoves || parameters.costCacheSize > 0 ||
+        parameters.speculativeMoves > 1 || parameters.rejectionFreeThreshold > 0 || parameters.islands > 1 || parameters.workers > 1 ||
+        parameters.repackWindow > 1 || parameters.skylineSeed)
+    {
+        return false;
+    }
+    if (numNodes <= 8)
+    {
+        runSmallScheduler<8>(macros, minAspectRatio, maxAspectRatio, input, logFile, parameters);
+    }
+    else if (numNodes <= 16)
+    {
+        runSmallScheduler<16>(macros, minAspectRatio, maxAspectRatio, input, logFile, parameters);
+    }
+    else if (numNodes <= 32)
+    {
+        runSmallScheduler<32>(macros, minAspectRatio, maxAspectRatio, input, logFile, parameters);
+    }
+    else
+    {
+        runSmallScheduler<64>(macros, minAspectRatio, maxAspectRatio, input, logFile, parameters);
+    }
+    return true;
+}
+
+bool API::isWorker(int argc, char **argv)
+{
+#ifdef HAS_WORKER_PROCESSES
+    return argc == 6 && strcmp(argv[1], WORKER_ARGUMENT) == 0;
+#else
+    return false;
+#endif
+}
+
+int API::runWorker(int, char **argv)
 {
+#ifdef HAS_WORKER_PROCESSES
+    try
+    {
+        SharedSlots slots(argv[2]);
+        const Parameters &parameters = slots.getParameters();
+        float minAspectRatio, maxAspectRatio;
+        Netlist netlist;
+        vector<Macro> macros = getMacros(parameters.inputFile, minAspectRatio, maxAspectRatio, netlist);
+        if (static_cast<int>(macros.size()) != slots.getNumNodes())
+        {
+            throw runtime_error("Input file changed since the run started");
+        }
+        function<Scheduler *()> createScheduler = [&]()
+        {
+            return createWorkerScheduler(macros, minAspectRatio, maxAspectRatio, netlist, parameters);
+        };
+        return WorkerProcesses<Scheduler>::work(slots, stoi(argv[3]), static_cast<unsigned>(stoul(argv[4])), createScheduler, argv[5]);
+    }
+    catch (exception &e)
+    {
+        cerr << "Worker: " << e.what() << endl;
+    }
+#endif
+    return 1;
+}
+
+void API::run(const Parameters &requested)
+{
+    Parameters parameters = requested;
     task_running = true;
     task_done = false;
     task_progress = 0.0f;
@@ -90,16 +452,38 @@ void API::run(const Parameters &parameters)
     logFile << "Start time: " << put_time(localtime(&in_time_t), "%Y-%m-%d %H:%M:%S") << endl;
     logFile << "Input file: " << parameters.inputFile << endl;
     logFile << "Output file: " << parameters.outputFile << endl;
+    const char *engines[] = {"sequence pair", "B*-tree", "slicing", "TCG", "genetic"};
+    logFile << "Engine: " << engines[parameters.engine] << endl;
+    logFile << "Transitive reduction: " << (parameters.transitiveReduction ? "on" : "off") << endl;
+    if (parameters.tunedParameters[0] && parameters.sweepMode == NO_SWEEP)
+    {
+        try
+        {
+            ParameterSweep::load(parameters.tunedParameters, parameters);
+        }
+        catch (exception &e)
+        {
+            logFile << "Error: " << e.what() << endl;
+            error_message = strdup(e.what());
+            task_running = false;
+            return;
+        }
+        logFile << "Tuned parameters: " << parameters.tunedParameters << endl;
+    }
 
     static float minAspectRatio = 0, maxAspectRatio = 0;
     static vector<Macro> macros;
+    static Netlist netlist;
     static Scheduler *scheduler = nullptr;
     static char lastInputFile[256] = "";
+    static int inputs = 0;
+    static bool lastTransitiveReduction = false;
+    static int lastMovesFactor = 7;
     if (memcmp(lastInputFile, parameters.inputFile, 256) != 0)
     {
         try
         {
-            macros = getMacros(parameters.inputFile, minAspectRatio, maxAspectRatio);
+            macros = getMacros(parameters.inputFile, minAspectRatio, maxAspectRatio, netlist);
         }
         catch (exception &e)
         {
@@ -111,25 +495,138 @@ void API::run(const Parameters &parameters)
         if (scheduler)
         {
             delete scheduler;
+            scheduler = nullptr;
         }
-        scheduler = new Scheduler(macros, minAspectRatio, maxAspectRatio);
         strcpy(lastInputFile, parameters.inputFile);
+        inputs++;
     }
 
-    SA::run(*scheduler, logFile, parameters);
-
-    in_time_t = chrono::system_clock::to_time_t(chrono::system_clock::now());
-    logFile << "End time: " << put_time(localtime(&in_time_t), "%Y-%m-%d %H:%M:%S") << endl;
+    if (parameters.sweepMode != NO_SWEEP)
+    {
+        switch (parameters.engine)
+        {
+        case B_STAR_TREE:
+            runSweep<BStarTreeScheduler>([&](int k)
+                                         { return new BStarTreeScheduler(macros, minAspectRatio, maxAspectRatio, k); },
+                                         logFile, parameters);
+            break;
+        case SLICING:
+            runSweep<SlicingScheduler>([&](int k)
+                                       { return new SlicingScheduler(macros, minAspectRatio, maxAspectRatio, k); },
+                                       logFile, parameters);
+            break;
+        case TCG:
+            runSweep<TCGScheduler>([&](int k)
+                                   { return new TCGScheduler(macros, minAspectRatio, maxAspectRatio, k); },
+                                   logFile, parameters);
+            break;
+        default:
+            runSweep<Scheduler>([&](int k)
+                                {
+                                    Scheduler *scheduler = new Scheduler(macros, minAspectRatio, maxAspectRatio, k, 10, parameters.transitiveReduction);
+                                    configureScheduler(*scheduler, netlist, parameters);
+                                    return scheduler; },
+                                logFile, parameters);
+            break;
+        }
+        task_done = true;
+        return;
+    }
 
-    try
+    switch (parameters.engine)
     {
-        scheduler->saveFloorplan(parameters.outputFile);
-        std::system(("gnuplot " + string(parameters.outputFile)).c_str());
+    case B_STAR_TREE:
+    {
+        BStarTreeScheduler bStarTreeScheduler(macros, minAspectRatio, maxAspectRatio, parameters.movesFactor);
+        runScheduler(bStarTreeScheduler, logFile, parameters);
+        break;
     }
-    catch (exception &e)
+    case SLICING:
     {
-        logFile << "Error: " << e.what() << endl;
-        error_message = strdup(e.what());
+        SlicingScheduler slicingScheduler(macros, minAspectRatio, maxAspectRatio, parameters.movesFactor);
+        runScheduler(slicingScheduler, logFile, parameters);
+        break;
+    }
+    case TCG:
+    {
+        TCGScheduler tcgScheduler(macros, minAspectRatio, maxAspectRatio, parameters.movesFactor);
+        runScheduler(tcgScheduler, logFile, parameters);
+        break;
+    }
+    case GENETIC:
+    {
+        GeneticScheduler geneticScheduler(macros, minAspectRatio, maxAspectRatio, parameters.movesFactor);
+        geneticScheduler.run(logFile, parameters);
+        finishRun(geneticScheduler, logFile, parameters);
+        break;
+    }
+
+    default:
+        if (parameters.clusterSize > 1)
+        {
+            HierarchicalScheduler hierarchicalScheduler(macros, minAspectRatio, maxAspectRatio, parameters.movesFactor);
+            hierarchicalScheduler.run(logFile, parameters);
+            finishRun(hierarchicalScheduler, logFile, parameters);
+            break;
+        }
+        if (parameters.multilevelSize > 0)
+        {
+            MultilevelScheduler multilevelScheduler(macros, minAspectRatio, maxAspectRatio, parameters.movesFactor);
+            multilevelScheduler.run(logFile, parameters);
+            finishRun(multilevelScheduler, logFile, parameters);
+            break;
+        }
+        if (parameters.windowSize > 0)
+        {
+            WindowedScheduler windowedScheduler(macros, minAspectRatio, maxAspectRatio, parameters.movesFactor);
+            windowedScheduler.run(logFile, parameters);
+            finishRun(windowedScheduler, logFile, parameters);
+            break;
+        }
+        if (parameters.workers > 1)
+        {
+            runWorkers(macros, minAspectRatio, maxAspectRatio, netlist, logFile, parameters);
+            break;
+        }
+        if (parameters.islands > 1)
+        {
+            runIslands(macros, minAspectRatio, maxAspectRatio, netlist, logFile, parameters);
+            break;
+        }
+        // the fixed-size sequence pairs only know max(width, height)
+        if ((netlist.empty() || parameters.wirelengthWeight <= 0) && (parameters.dieWidth <= 0 || parameters.dieHeight <= 0) &&
+            runSmallScheduler(macros, minAspectRatio, maxAspectRatio, inputs, logFile, parameters))
+        {
+            break;
+        }
+        if (scheduler && (lastTransitiveReduction != parameters.transitiveReduction || lastMovesFactor != parameters.movesFactor))
+        {
+            delete scheduler;
+            scheduler = nullptr;
+        }
+        logFile << "Sequence pair: constraint graphs" << (scheduler ? ", continued" : "") << endl;
+        if (!scheduler)
+        {
+            scheduler = new Scheduler(macros, minAspectRatio, maxAspectRatio, parameters.movesFactor, 10, parameters.transitiveReduction);
+            lastTransitiveReduction = parameters.transitiveReduction;
+            lastMovesFactor = parameters.movesFactor;
+        }
+        configureScheduler(*scheduler, netlist, parameters);
+        if (scheduler->hasOutline())
+        {
+            logFile << "Die: " << parameters.dieWidth << " x " << parameters.dieHeight << ", outline penalty: " << parameters.outlinePenalty << endl;
+        }
+        if (!netlist.empty())
+        {
+            logFile << "Nets: " << netlist.size() << ", pins: " << netlist.getNumPins() << ", wirelength weight: " << parameters.wirelengthWeight << endl;
+        }
+        if (parameters.skylineSeed)
+        {
+            logFile << "Skyline seed: " << seedSequencePair(*scheduler) << endl;
+        }
+        SA::run(*scheduler, logFile, parameters);
+        finishSequencePair(*scheduler, logFile, parameters);
+        break;
     }
 
     task_done = true;
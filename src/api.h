@@ -27,6 +27,38 @@ namespace API
      */
     std::ofstream getLogFile();
 
+    /**
+     * Floorplan representations the annealer can drive.
+     */
+    enum Engine
+    {
+        SEQUENCE_PAIR,
+        B_STAR_TREE,
+        SLICING,
+        TCG,
+        GENETIC
+    };
+
+    /**
+     * Islands receiving the states an island migrates.
+     */
+    enum Topology
+    {
+        RING,
+        FULLY_CONNECTED
+    };
+
+    /**
+     * The search of a parameter sweep.
+     */
+    enum Sweep
+    {
+        NO_SWEEP,
+        GRID_SWEEP,
+        RANDOM_SWEEP,
+        SUCCESSIVE_HALVING
+    };
+
     /**
      * Parameters for the API.
      *
@@ -39,6 +71,42 @@ namespace API
      *
      * Optional:
      * targetIterations: The number of iterations to run the algorithm for.
+     * engine: The floorplan representation.
+     * transitiveReduction: Whether to keep only the transitively reduced constraint graphs.
+     * criticalMoves: Whether to bias moves toward critical blocks.
+     * targetCost: The cost whose first hit is reported in the log.
+     * costCacheSize: The number of entries of the cost cache.
+     * threads: The number of threads of a single evaluation.
+     * speculativeMoves: The number of moves proposed and evaluated ahead per step.
+     * islands: The number of sequence pair chains annealed in parallel.
+     * migrationInterval: The number of iterations between two migrations.
+     * migrationTopology: The islands receiving the states an island migrates.
+     * windowSize: The number of blocks of a window in the domain decomposition mode.
+     * workers: The number of worker processes annealing independent chains.
+     * stallTimeout: The seconds without progress before a worker is restarted.
+     * pinThreads: Whether to pin annealing threads and workers to cores.
+     * movesFactor: The moves per block of an iteration.
+     * sweepMode: The search of a parameter sweep instead of a single run.
+     * sweepSamples: The number of configurations of a random sweep.
+     * tunedParameters: The file of the best swept schedule.
+     * populationSize: The number of individuals of the genetic engine.
+     * generations: The number of generations of the genetic engine.
+     * polishMoves: The annealing moves polishing each elite individual per generation.
+     * rejectionFreeThreshold: The acceptance ratio below which annealing turns rejection-free.
+     * rejectionFreeMoves: The number of moves scored per rejection-free step.
+     * repackWindow: The number of blocks of a window repacked exactly after annealing.
+     * repackRounds: The number of rounds of window repacking.
+     * exactSolve: Whether to compare the result with the optimum of a small design.
+     * exactTimeLimit: The seconds the exact solver may search.
+     * skylineSeed: Whether the sequence pair starts from a skyline packing.
+     * clusterSize: The number of blocks or clusters of a cluster in the hierarchical mode.
+     * clusterDepth: The number of cluster levels in the hierarchical mode.
+     * multilevelSize: The number of blocks of the coarsest level of the multilevel mode.
+     * refineMoves: The moves of a refinement pass of the multilevel mode.
+     * wirelengthWeight: The weight of the average net wirelength in the cost.
+     * dieWidth: The width of the fixed outline.
+     * dieHeight: The height of the fixed outline.
+     * outlinePenalty: The cost of a unit beyond the fixed outline.
      */
     struct Parameters
     {
@@ -54,7 +122,254 @@ namespace API
          * Default is 0.
          */
         int targetIterations = 0;
+
+        /**
+         * Optional. The floorplan representation, one of Engine.
+         * The sequence pair state is kept between runs on the same input, the
+         * other representations start over on every run. Default is SEQUENCE_PAIR.
+         */
+        int engine = SEQUENCE_PAIR;
+
+        /**
+         * Optional. Keep only the transitively reduced constraint graph edges.
+         * Default is false.
+         */
+        bool transitiveReduction = false;
+
+        /**
+         * Optional. Bias swaps and reshapes toward blocks with zero slack on the
+         * critical path. Default is false.
+         */
+        bool criticalMoves = false;
+
+        /**
+         * Optional. Log the number of moves needed to first reach this cost.
+         * If set to 0, nothing is reported. Default is 0.
+         */
+        double targetCost = 0;
+
+        /**
+         * Optional. Number of entries of the evaluated-state cost cache.
+         * If set to 0, the cache is disabled. Default is 0.
+         */
+        int costCacheSize = 0;
+
+        /**
+         * Optional. Threads relaxing the constraint graphs level by level. Graphs
+         * below a few thousand vertices are always evaluated serially. Default is 1.
+         */
+        int threads = 1;
+
+        /**
+         * Optional. Proposals drawn from the current state and evaluated at once
+         * on the threads; the first accepted one in order is committed. Ignored
+         * with critical moves. If set to 0 or 1, moves are evaluated one by one.
+         * Default is 0.
+         */
+        int speculativeMoves = 0;
+
+        /**
+         * Optional. Sequence pair chains annealed on their own threads, the best
+         * one is saved. If set to 0 or 1, a single chain is run. Default is 0.
+         */
+        int islands = 0;
+
+        /**
+         * Optional. Iterations between two migrations of the best state of an
+         * island to its neighbours. If set to 0, the islands are independent
+         * restarts. Default is 5.
+         */
+        int migrationInterval = 5;
+
+        /**
+         * Optional. The islands receiving the states, one of Topology.
+         * Default is RING.
+         */
+        int migrationTopology = RING;
+
+        /**
+         * Optional. Split the sequence pair into windows of this many blocks
+         * annealed concurrently on the threads, for designs of tens of thousands
+         * of blocks. If set to 0, the whole sequence pair is annealed as one.
+         * Default is 0.
+         */
+        int windowSize = 0;
+
+        /**
+         * Optional. Start this many worker processes, each annealing its own
+         * sequence pair from its own seed and publishing its best state to shared
+         * memory. POSIX only. If set to 0, the run stays in this process.
+         * Default is 0.
+         */
+        int workers = 0;
+
+        /**
+         * Optional. Seconds a worker may go without finishing an iteration before
+         * it is killed and restarted. If set to 0, workers are never restarted
+         * for stalling. Default is 60.
+         */
+        int stallTimeout = 60;
+
+        /**
+         * Optional. Pin the island threads, window threads and worker processes
+         * to cores, spread over packages first, and build their state after
+         * pinning so it stays on the local NUMA node. Linux only.
+         * Default is false.
+         */
+        bool pinThreads = false;
+
+        /**
+         * Optional. Moves per block and direction of an iteration, the k of the
+         * schedulers. Default is 7.
+         */
+        int movesFactor = 7;
+
+        /**
+         * Optional. Instead of a single run, sweep temperature, coolingRate,
+         * absoluteTemperature, targetIterations and movesFactor around the given
+         * values on the threads, one of Sweep. Default is NO_SWEEP.
+         */
+        int sweepMode = NO_SWEEP;
+
+        /**
+         * Optional. Configurations of a random or successive halving sweep.
+         * Default is 16.
+         */
+        int sweepSamples = 16;
+
+        /**
+         * Optional. A sweep saves its best configuration to this file, and any
+         * other run loads its schedule from it. If empty, nothing is saved or
+         * loaded. Default is empty.
+         */
+        char tunedParameters[256] = "";
+
+        /**
+         * Optional. Individuals of the genetic engine, bred and evaluated on the
+         * threads. Default is 64.
+         */
+        int populationSize = 64;
+
+        /**
+         * Optional. Generations of the genetic engine. Default is 200.
+         */
+        int generations = 200;
+
+        /**
+         * Optional. Annealing moves polishing each elite individual of the genetic
+         * engine every generation, at the temperature cooled once per generation.
+         * If set to 0, the elite is not polished. Default is 0.
+         */
+        int polishMoves = 0;
+
+        /**
+         * Optional. Once the acceptance ratio of an iteration falls below this, the
+         * annealing scores rejectionFreeMoves proposals per step on the threads and
+         * applies one drawn in proportion to its acceptance probability, counting
+         * the moves it stands for as simulated time. Sequence pair only. If set to
+         * 0, every step is a plain Metropolis trial. Default is 0.
+         */
+        double rejectionFreeThreshold = 0;
+
+        /**
+         * Optional. Moves scored per rejection-free step. Default is 64.
+         */
+        int rejectionFreeMoves = 64;
+
+        /**
+         * Optional. After annealing a sequence pair, rip up windows of this many
+         * neighbouring blocks, at most 8, and put each back with the best
+         * arrangement and shapes found by branch and bound, on the threads. If set
+         * to 0, the annealed floorplan is kept as it is. Default is 0.
+         */
+        int repackWindow = 0;
+
+        /**
+         * Optional. Rounds of window repacking over every block, stopping early at
+         * the first round without an improvement. Default is 10.
+         */
+        int repackRounds = 10;
+
+        /**
+         * Optional. After the run, search every sequence pair and shape choice of
+         * a design of at most 12 blocks by branch and bound on the threads, and
+         * log the optimum and the optimality gap of the result. Default is false.
+         */
+        bool exactSolve = false;
+
+        /**
+         * Optional. Seconds the exact solver may search before it reports the best
+         * floorplan found as unproven. Default is 60.
+         */
+        double exactTimeLimit = 60;
+
+        /**
+         * Optional. Start the sequence pair from the best skyline packing of the
+         * blocks instead of the identity sequences with random shapes, so the
+         * anneal can start at a lower temperature. Default is false.
+         */
+        bool skylineSeed = false;
+
+        /**
+         * Optional. Cluster the blocks by area into groups of this size, floorplan
+         * every cluster on the threads, and anneal the clusters as soft blocks with
+         * their floorplans as shape options. 0 anneals the design flat. Default is 0.
+         */
+        int clusterSize = 0;
+
+        /**
+         * Optional. Levels of clusters of clusters built before the top level is
+         * annealed. Default is 1.
+         */
+        int clusterDepth = 1;
+
+        /**
+         * Optional. Merge pairs of blocks into composite blocks until at most this
+         * many are left, anneal them, and refine every finer level on the way back
+         * to the blocks. 0 anneals the design flat. Default is 0.
+         */
+        int multilevelSize = 0;
+
+        /**
+         * Optional. Moves of the low temperature pass refining each level of the
+         * multilevel mode, 0 only projects the coarse floorplan. Default is 20000.
+         */
+        int refineMoves = 20000;
+
+        /**
+         * Optional. Weight of the average half-perimeter wirelength of the nets of
+         * the input in the cost of the sequence pair, added to max(width, height).
+         * Ignored without nets, 0 only reports the wirelength. Default is 1.
+         */
+        double wirelengthWeight = 1;
+
+        /**
+         * Optional. Fixed outline of the die the sequence pair must fit in. The cost
+         * becomes max(width, height * dieWidth / dieHeight) plus the penalty for every
+         * unit beyond the outline on each axis, and the log reports when the first
+         * floorplan inside the die was found. 0 for either side minimises
+         * max(width, height) instead. Default is 0.
+         */
+        int dieWidth = 0;
+        int dieHeight = 0;
+
+        /**
+         * Optional. Cost of a unit of width or height beyond the fixed outline.
+         * Default is 10.
+         */
+        double outlinePenalty = 10;
     };
 
     void run(const Parameters &parameters);
+
+    /**
+     * Whether the arguments of the executable start a worker process of a run.
+     * Checked first thing in main, before any thread exists.
+     */
+    bool isWorker(int argc, char **argv);
+
+    /**
+     * Run the worker process given by the arguments, returns its exit status.
+     */
+    int runWorker(int argc, char **argv);
 }
@@ -41,8 +41,12 @@ static void glfw_error_callback(int error, const char *description)
 }
 
 // Main code
-int main(int, char **)
+int main(int argc, char **argv)
 {
+    // worker processes start this executable again, before any thread exists
+    if (API::isWorker(argc, argv))
+        return API::runWorker(argc, argv);
+
     glfwSetErrorCallback(glfw_error_callback);
     if (!glfwInit())
         return 1;
@@ -209,6 +213,111 @@ int main(int, char **)
             ImGui::InputInt("Target Iterations", &parameters.targetIterations);
             ImGui::SameLine();
             HelpMarker("Set to 0 to run until the absolute temperature is reached.");
+            const char *engines[] = {"Sequence Pair", "B*-tree", "Slicing", "TCG", "Genetic"};
+            ImGui::Combo("Engine", &parameters.engine, engines, IM_ARRAYSIZE(engines));
+            ImGui::Checkbox("Transitive Reduction", &parameters.transitiveReduction);
+            ImGui::SameLine();
+            HelpMarker("Keep only the transitively reduced constraint graph edges.");
+            ImGui::Checkbox("Critical Moves", &parameters.criticalMoves);
+            ImGui::SameLine();
+            HelpMarker("Bias swaps and reshapes toward blocks with zero slack.");
+            ImGui::InputDouble("Target Cost", &parameters.targetCost);
+            ImGui::SameLine();
+            HelpMarker("Report the moves needed to reach this cost. Set to 0 to disable.");
+            ImGui::InputInt("Cost Cache Size", &parameters.costCacheSize);
+            ImGui::SameLine();
+            HelpMarker("Entries of the evaluated-state cost cache. Set to 0 to disable.");
+            ImGui::InputInt("Threads", &parameters.threads);
+            ImGui::SameLine();
+            HelpMarker("Threads of a single evaluation, used on graphs of thousands of blocks.");
+            ImGui::InputInt("Speculative Moves", &parameters.speculativeMoves);
+            ImGui::SameLine();
+            HelpMarker("Moves evaluated ahead from the same state on the threads. Set to 0 to evaluate one at a time.");
+            ImGui::InputInt("Islands", &parameters.islands);
+            ImGui::SameLine();
+            HelpMarker("Sequence pair chains annealed in parallel. Set to 0 for a single chain.");
+            ImGui::InputInt("Migration Interval", &parameters.migrationInterval);
+            ImGui::SameLine();
+            HelpMarker("Iterations between migrations of the best island states. Set to 0 for independent restarts.");
+            const char *topologies[] = {"Ring", "Fully Connected"};
+            ImGui::Combo("Migration Topology", &parameters.migrationTopology, topologies, IM_ARRAYSIZE(topologies));
+            ImGui::InputInt("Window Size", &parameters.windowSize);
+            ImGui::SameLine();
+            HelpMarker("Blocks per window annealed concurrently on huge designs. Set to 0 to anneal the whole sequence pair.");
+            ImGui::InputInt("Workers", &parameters.workers);
+            ImGui::SameLine();
+            HelpMarker("Worker processes annealing from their own seeds, the best result is kept. Set to 0 to run in this process.");
+            ImGui::InputInt("Stall Timeout", &parameters.stallTimeout);
+            ImGui::SameLine();
+            HelpMarker("Seconds without progress before a worker is restarted. Set to 0 to never restart.");
+            ImGui::Checkbox("Pin Threads", &parameters.pinThreads);
+            ImGui::SameLine();
+            HelpMarker("Pin islands, windows and workers to cores, one per core and package first.");
+            ImGui::InputInt("Moves Factor", &parameters.movesFactor);
+            ImGui::SameLine();
+            HelpMarker("Moves per block of an iteration.");
+            const char *sweeps[] = {"None", "Grid", "Random", "Successive Halving"};
+            ImGui::Combo("Sweep", &parameters.sweepMode, sweeps, IM_ARRAYSIZE(sweeps));
+            ImGui::SameLine();
+            HelpMarker("Search the schedule and moves factor around the values above instead of a single run.");
+            ImGui::InputInt("Sweep Samples", &parameters.sweepSamples);
+            ImGui::SameLine();
+            HelpMarker("Configurations of a random or successive halving sweep.");
+            ImGui::InputText("Tuned Parameters", parameters.tunedParameters, IM_ARRAYSIZE(parameters.tunedParameters));
+            ImGui::SameLine();
+            HelpMarker("File a sweep saves its best schedule to, and other runs load theirs from. Leave empty to skip.");
+            ImGui::InputInt("Population Size", &parameters.populationSize);
+            ImGui::SameLine();
+            HelpMarker("Individuals of the genetic engine.");
+            ImGui::InputInt("Generations", &parameters.generations);
+            ImGui::SameLine();
+            HelpMarker("Generations of the genetic engine.");
+            ImGui::InputInt("Polish Moves", &parameters.polishMoves);
+            ImGui::SameLine();
+            HelpMarker("Annealing moves on each elite individual per generation. Set to 0 to skip.");
+            ImGui::InputDouble("Rejection-Free Threshold", &parameters.rejectionFreeThreshold);
+            ImGui::SameLine();
+            HelpMarker("Acceptance ratio below which every step scores many moves and applies one. Set to 0 to disable.");
+            ImGui::InputInt("Rejection-Free Moves", &parameters.rejectionFreeMoves);
+            ImGui::SameLine();
+            HelpMarker("Moves scored per rejection-free step.");
+            ImGui::InputInt("Repack Window", &parameters.repackWindow);
+            ImGui::SameLine();
+            HelpMarker("Neighbouring blocks, at most 8, rearranged exactly after annealing. Set to 0 to skip.");
+            ImGui::InputInt("Repack Rounds", &parameters.repackRounds);
+            ImGui::SameLine();
+            HelpMarker("Rounds of window repacking, stopping at the first without an improvement.");
+            ImGui::Checkbox("Exact Solve", &parameters.exactSolve);
+            ImGui::SameLine();
+            HelpMarker("Find the optimum of a design of at most 12 blocks and log the optimality gap of the result.");
+            ImGui::InputDouble("Exact Time Limit", &parameters.exactTimeLimit);
+            ImGui::SameLine();
+            HelpMarker("Seconds the exact solver may search.");
+            ImGui::Checkbox("Skyline Seed", &parameters.skylineSeed);
+            ImGui::SameLine();
+            HelpMarker("Start the sequence pair from a skyline packing of the blocks, allowing a lower starting temperature.");
+            ImGui::InputInt("Cluster Size", &parameters.clusterSize);
+            ImGui::SameLine();
+            HelpMarker("Blocks per cluster of the hierarchical mode, 0 anneals the design flat.");
+            ImGui::InputInt("Cluster Depth", &parameters.clusterDepth);
+            ImGui::SameLine();
+            HelpMarker("Levels of clusters of clusters in the hierarchical mode.");
+            ImGui::InputInt("Multilevel Size", &parameters.multilevelSize);
+            ImGui::SameLine();
+            HelpMarker("Blocks of the coarsest level of the multilevel mode, 0 anneals the design flat.");
+            ImGui::InputInt("Refine Moves", &parameters.refineMoves);
+            ImGui::SameLine();
+            HelpMarker("Moves of the refinement pass at every level of the multilevel mode.");
+            ImGui::InputDouble("Wirelength Weight", &parameters.wirelengthWeight);
+            ImGui::SameLine();
+            HelpMarker("Weight of the average net wirelength in the sequence pair cost, for inputs with nets.");
+            ImGui::InputInt("Die Width", &parameters.dieWidth);
+            ImGui::InputInt("Die Height", &parameters.dieHeight);
+            ImGui::SameLine();
+            HelpMarker("Fixed outline the sequence pair must fit in, 0 minimises max(width, height).");
+            ImGui::InputDouble("Outline Penalty", &parameters.outlinePenalty);
+            ImGui::SameLine();
+            HelpMarker("Cost of a unit of width or height beyond the fixed outline.");
 
             static int status = 0;
             static bool completed = false;